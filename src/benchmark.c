@@ -0,0 +1,229 @@
+// Renderer benchmark suite: replays a fixed camera path through
+// renderScene() on each shipped map, at several resolutions, with
+// performance mode off and on, and reports frame-time percentiles and
+// pixel throughput as JSON. Numbers are meant to be compared between
+// builds on the same machine.
+#include "raywhen.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "map.h"
+#include "player.h"
+#include "enemy.h"
+#include "renderer.h"
+#include "threadpool.h"
+#include "raster.h"
+#include "raycache.h"
+#include "profiler.h"
+
+// Global screen dimensions (set per run)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+static const char *benchMaps[] = {
+    "maps/arena.rwm",
+    "maps/map.rwm",
+    "maps/littlehouse.rwm"
+};
+#define BENCH_MAP_COUNT (int)(sizeof(benchMaps) / sizeof(benchMaps[0]))
+
+static const int benchResolutions[][2] = {
+    { 640, 480 },
+    { 1024, 768 },
+    { 1920, 1080 },
+    { 3840, 2160 }
+};
+#define BENCH_RESOLUTION_COUNT (int)(sizeof(benchResolutions) / sizeof(benchResolutions[0]))
+
+// One camera pose per frame
+typedef struct {
+    double x, y, angle, pitch;
+} CameraPose;
+
+#define PATH_STEP 0.04      // world units walked per frame
+#define PATH_PITCH 40.0     // peak pitchOffset in pixels
+#define PATH_CLEARANCE 0.25 // keep the camera this far from walls
+
+// Build the path for the loaded map: one full turn from the spawn point,
+// walking forward wherever the map allows it and nodding up and down.
+// Depends only on the map, so every resolution/mode sees the same poses.
+static void buildCameraPath(CameraPose *path, int frames) {
+    double x = playerX, y = playerY;
+    for (int i = 0; i < frames; ++i) {
+        double t = (double)i / frames;
+        double angle = t * 2.0 * M_PI;
+        double dx = cos(angle) * PATH_STEP;
+        double dy = sin(angle) * PATH_STEP;
+        if (canMoveTo(x + dx + (dx < 0 ? -PATH_CLEARANCE : PATH_CLEARANCE), y)) x += dx;
+        if (canMoveTo(x, y + dy + (dy < 0 ? -PATH_CLEARANCE : PATH_CLEARANCE))) y += dy;
+        path[i].x = x;
+        path[i].y = y;
+        path[i].angle = angle;
+        path[i].pitch = sin(t * 4.0 * M_PI) * PATH_PITCH;
+    }
+}
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+static void printUsage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -frames <n>    Frames per run (default 120)\n");
+    printf("  -warmup <n>    Untimed frames before each run (default 10)\n");
+    printf("  -threads <n>   Render threads (0 = one per CPU, default 1)\n");
+    printf("  -simd <path>   Force SIMD kernels: scalar, sse2 or avx2 (default: best spans, scalar rays)\n");
+    printf("  -raycast <m>   Raycast arithmetic: double, float or fixed (default %s)\n", rayCastPrecisionName());
+    printf("  -ray-cache     Reuse rays while the view only turns (off by default)\n");
+    printf("  -maxres <w>    Skip resolutions wider than w\n");
+    printf("  -o <file>      Write JSON here instead of stdout\n");
+}
+
+int main(int argc, char **argv) {
+    int frames = 120;
+    int warmup = 10;
+    int maxWidth = 1 << 30;
+    const char *simdPath = NULL;
+    const char *precisionName = NULL;
+    const char *outPath = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-frames") == 0 && next) {
+            frames = atoi(next); i++;
+            if (frames < 1) frames = 1;
+        } else if (strcmp(arg, "-warmup") == 0 && next) {
+            warmup = atoi(next); i++;
+            if (warmup < 0) warmup = 0;
+        } else if ((strcmp(arg, "-threads") == 0 || strcmp(arg, "--threads") == 0) && next) {
+            int n = atoi(next); i++;
+            if (n >= 0 && n <= MAX_RENDER_THREADS) renderThreadCount = n;
+        } else if (strcmp(arg, "-simd") == 0 && next) {
+            simdPath = next; i++;
+        } else if (strcmp(arg, "-raycast") == 0 && next) {
+            precisionName = next; i++;
+        } else if (strcmp(arg, "-ray-cache") == 0) {
+            rayCacheEnabled = 1;
+        } else if (strcmp(arg, "-maxres") == 0 && next) {
+            maxWidth = atoi(next); i++;
+        } else if (strcmp(arg, "-o") == 0 && next) {
+            outPath = next; i++;
+        } else if (strcmp(arg, "-help") == 0 || strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    threadPoolInit(renderThreadCount);
+    rasterInit();
+    if (simdPath && !rasterSelect(simdPath)) {
+        fprintf(stderr, "Span kernels '%s' not available on this CPU\n", simdPath);
+        return 1;
+    }
+    if (precisionName && !rayCastPrecisionSelect(precisionName)) {
+        fprintf(stderr, "Unknown raycast arithmetic '%s'\n", precisionName);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (outPath) {
+        out = fopen(outPath, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open %s\n", outPath);
+            return 1;
+        }
+    }
+
+    CameraPose *path = (CameraPose*)malloc(sizeof(CameraPose) * frames);
+    double *samples = (double*)malloc(sizeof(double) * frames);
+    if (!path || !samples) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"threads\": %d,\n  \"span_kernels\": \"%s\",\n  \"ray_kernel\": \"%s\",\n"
+            "  \"raycast\": \"%s\",\n  \"ray_cache\": %s,\n", threadPoolSize(), rasterPathName(), rayCastKernelName(),
+            rayCastPrecisionName(), rayCacheEnabled ? "true" : "false");
+    fprintf(out, "  \"frames\": %d,\n  \"warmup\": %d,\n  \"runs\": [", frames, warmup);
+
+    int ok = 1;
+    int firstRun = 1;
+    for (int m = 0; m < BENCH_MAP_COUNT && ok; ++m) {
+        // Maps without a spawn marker keep the default start
+        setPlayerPosition(8.5, 8.5);
+        playerAngle = 0.0;
+        pitchOffset = 0.0;
+        if (!loadMapFromFile(benchMaps[m])) {
+            fprintf(stderr, "Failed to load map: %s\n", benchMaps[m]);
+            ok = 0;
+            break;
+        }
+        buildCameraPath(path, frames);
+
+        for (int r = 0; r < BENCH_RESOLUTION_COUNT && ok; ++r) {
+            const int width = benchResolutions[r][0];
+            const int height = benchResolutions[r][1];
+            if (width > maxWidth) continue;
+            SCREEN_WIDTH = width;
+            SCREEN_HEIGHT = height;
+            Framebuffer fb;
+            if (!framebufferCreate(&fb, width, height) || !ensureDepthBuffer(width)) {
+                fprintf(stderr, "Out of memory allocating %dx%d framebuffer\n", width, height);
+                ok = 0;
+                break;
+            }
+
+            for (int perf = 0; perf <= 1; ++perf) {
+                simpleShadingMode = perf;
+                for (int i = -warmup; i < frames; ++i) {
+                    const CameraPose *pose = &path[i < 0 ? 0 : i];
+                    playerX = pose->x;
+                    playerY = pose->y;
+                    playerAngle = pose->angle;
+                    pitchOffset = pose->pitch;
+                    double t0 = profilerNow();
+                    renderScene(&fb);
+                    if (i >= 0) samples[i] = profilerNow() - t0;
+                }
+
+                double total = 0.0;
+                for (int i = 0; i < frames; ++i) total += samples[i];
+                qsort(samples, frames, sizeof(double), compareDouble);
+                double mpix = (double)width * height * frames / (total * 1000.0);
+
+                fprintf(out, "%s\n    {\"map\": \"%s\", \"width\": %d, \"height\": %d, \"perf\": %s,\n",
+                    firstRun ? "" : ",", benchMaps[m], width, height, perf ? "true" : "false");
+                fprintf(out, "     \"ms\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f},\n",
+                    samples[0], percentile(samples, frames, 50.0), percentile(samples, frames, 90.0),
+                    percentile(samples, frames, 99.0), samples[frames - 1], total / frames);
+                fprintf(out, "     \"mpixels_per_s\": %.1f}", mpix);
+                firstRun = 0;
+
+                fprintf(stderr, "%-22s %4dx%-4d %-4s p50 %8.3f ms  %7.1f Mpix/s\n",
+                    benchMaps[m], width, height, perf ? "perf" : "", percentile(samples, frames, 50.0), mpix);
+            }
+            framebufferDestroy(&fb);
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout) fclose(out);
+    free(path);
+    free(samples);
+    freeDepthBuffer();
+    threadPoolShutdown();
+    return ok ? 0 : 1;
+}
@@ -24,6 +24,13 @@
 /* bmpread.c
  * version 3.0
  * 2018-02-02
+ *
+ * ALTERED SOURCE for RayWhen; this is not the original libbmpread.  Changes:
+ *  - BMPREAD_BGRA output mode (see bmpread.h), with fast paths for 24-bit
+ *    and standard 8-8-8 32-bit files that copy bytes instead of decoding.
+ *  - Uncompressed 16- and 32-bit files (default X1R5G5B5 and X8R8G8B8
+ *    masks) and bitfield masks after a Windows 3 (40-byte) info header are
+ *    accepted.
  */
 
 
@@ -297,15 +304,15 @@ static int ReadInfo(bmp_info * info, FILE * fp)
      */
     if(info->compression == COMPRESSION_BITFIELDS)
     {
-        /* Reject Windows NT format files with bitfields, since we don't
-         * support them, and their masks aren't part of the info header anyway.
+        /* Windows NT format files keep three masks (no alpha) right after
+         * the info header, which is where the file pointer is now; later
+         * formats have four inside the info header.
          */
-        if(info->info_size == BMP3_INFO_SIZE) return 0;
-
         if(!ReadLittleUint32(&info->masks[0], fp)) return 0;
         if(!ReadLittleUint32(&info->masks[1], fp)) return 0;
         if(!ReadLittleUint32(&info->masks[2], fp)) return 0;
-        if(!ReadLittleUint32(&info->masks[3], fp)) return 0;
+        if(info->info_size > BMP3_INFO_SIZE &&
+           !ReadLittleUint32(&info->masks[3], fp)) return 0;
     }
 
     return 1;
@@ -413,6 +420,8 @@ typedef struct read_context
     size_t         file_line_len; /* How many bytes each scan line is. */
     size_t         out_channels;  /* Output color channels (3, or 4=alpha). */
     size_t         out_line_len;  /* Bytes in each output line. */
+    size_t         red_at;        /* Offset of red in an output pixel. */
+    size_t         blue_at;       /* Offset of blue (0 or 2, for BGRA). */
     bitfield       bitfields[4];  /* How to decode 16- and 32-bits. */
     bmp_color    * palette;       /* Enough entries for our bit depth. */
     uint8_t      * file_data;     /* A line of data in the file. */
@@ -434,7 +443,7 @@ static int ValidateBitfields(read_context * p_ctx)
 
     int i;
 
-    if(p_ctx->info.compression != COMPRESSION_BITFIELDS)
+    if(p_ctx->info.bits != 16 && p_ctx->info.bits != 32)
         return 1;
 
     for(i = 0; i < 4; i++)
@@ -564,7 +573,25 @@ static int Validate(read_context * p_ctx)
     {
         case COMPRESSION_NONE:
             if(p_ctx->info.bits != 1 && p_ctx->info.bits != 4 &&
-               p_ctx->info.bits != 8 && p_ctx->info.bits != 24) return 0;
+               p_ctx->info.bits != 8 && p_ctx->info.bits != 16 &&
+               p_ctx->info.bits != 24 && p_ctx->info.bits != 32) return 0;
+
+            /* Uncompressed 16- and 32-bit data has a fixed layout with no
+             * alpha: X1R5G5B5 and X8R8G8B8.
+             */
+            if(p_ctx->info.bits == 16)
+            {
+                p_ctx->info.masks[0] = UINT32_C(0x7c00);
+                p_ctx->info.masks[1] = UINT32_C(0x03e0);
+                p_ctx->info.masks[2] = UINT32_C(0x001f);
+            }
+            else if(p_ctx->info.bits == 32)
+            {
+                p_ctx->info.masks[0] = UINT32_C(0x00ff0000);
+                p_ctx->info.masks[1] = UINT32_C(0x0000ff00);
+                p_ctx->info.masks[2] = UINT32_C(0x000000ff);
+            }
+            p_ctx->info.masks[3] = 0;
             break;
 
         case COMPRESSION_BITFIELDS:
@@ -578,7 +605,10 @@ static int Validate(read_context * p_ctx)
     p_ctx->file_line_len = GetLineLength(p_ctx->info.width, p_ctx->info.bits);
     if(p_ctx->file_line_len == 0) return 0;
 
-    p_ctx->out_channels = ((p_ctx->flags & BMPREAD_ALPHA) ? 4 : 3);
+    p_ctx->out_channels = ((p_ctx->flags & (BMPREAD_ALPHA | BMPREAD_BGRA)) ?
+                           4 : 3);
+    p_ctx->red_at  = ((p_ctx->flags & BMPREAD_BGRA) ? 2 : 0);
+    p_ctx->blue_at = 2 - p_ctx->red_at;
 
     /* This check happens outside the following if, where it would seem to
      * belong, because we make the same computation again in the future.
@@ -645,6 +675,17 @@ static uint32_t Make8Bits(uint32_t value, uint32_t bitspan)
                                ((uint32_t)(buf)[2] << 16) + \
                                ((uint32_t)(buf)[3] << 24))
 
+/* Writes one pixel's color components in output order (RGB, or BGR with
+ * BMPREAD_BGRA) and advances p_out past them.
+ */
+#define PutColor(p_out, r, g, b, p_ctx)                         \
+        do {                                                    \
+            (p_out)[(p_ctx)->red_at]  = (uint8_t)(r);           \
+            (p_out)[1]                = (uint8_t)(g);           \
+            (p_out)[(p_ctx)->blue_at] = (uint8_t)(b);           \
+            (p_out) += 3;                                       \
+        } while(0)
+
 /* Decodes 32-bit bitmap data by applying bitmasks.  The 16- and 32-bit
  * decoders could be made more efficient by whitelisting supported bit patterns
  * ahead of time and special-casing their decoding here, but this allows us to
@@ -666,12 +707,13 @@ static void Decode32(uint8_t * p_out,
     {
         uint32_t value = LoadLittleUint32(p_file);
 
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[0]), bf[0].span);
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[1]), bf[1].span);
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[2]), bf[2].span);
+        PutColor(p_out, Make8Bits(ApplyBitfield(value, bf[0]), bf[0].span),
+                        Make8Bits(ApplyBitfield(value, bf[1]), bf[1].span),
+                        Make8Bits(ApplyBitfield(value, bf[2]), bf[2].span),
+                 p_ctx);
         if(p_ctx->out_channels == 4)
         {
-            if(bf[3].span)
+            if(bf[3].span && (p_ctx->flags & BMPREAD_ALPHA))
                 *p_out++ = Make8Bits(ApplyBitfield(value, bf[3]), bf[3].span);
             else
                 *p_out++ = BMPREAD_DEFAULT_ALPHA;
@@ -691,9 +733,7 @@ static void Decode24(uint8_t * p_out,
 {
     while(p_out < p_out_end)
     {
-        *p_out++ = *(p_file + 2);
-        *p_out++ = *(p_file + 1);
-        *p_out++ = *(p_file    );
+        PutColor(p_out, *(p_file + 2), *(p_file + 1), *(p_file), p_ctx);
         if(p_ctx->out_channels == 4)
             *p_out++ = BMPREAD_DEFAULT_ALPHA;
 
@@ -719,12 +759,13 @@ static void Decode16(uint8_t * p_out,
     {
         uint16_t value = LoadLittleUint16(p_file);
 
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[0]), bf[0].span);
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[1]), bf[1].span);
-        *p_out++ = Make8Bits(ApplyBitfield(value, bf[2]), bf[2].span);
+        PutColor(p_out, Make8Bits(ApplyBitfield(value, bf[0]), bf[0].span),
+                        Make8Bits(ApplyBitfield(value, bf[1]), bf[1].span),
+                        Make8Bits(ApplyBitfield(value, bf[2]), bf[2].span),
+                 p_ctx);
         if(p_ctx->out_channels == 4)
         {
-            if(bf[3].span)
+            if(bf[3].span && (p_ctx->flags & BMPREAD_ALPHA))
                 *p_out++ = Make8Bits(ApplyBitfield(value, bf[3]), bf[3].span);
             else
                 *p_out++ = BMPREAD_DEFAULT_ALPHA;
@@ -742,9 +783,9 @@ static void Decode8(uint8_t * p_out,
                     const read_context * p_ctx)
 {
     while(p_out < p_out_end) {
-        *p_out++ = p_ctx->palette[*p_file].red;
-        *p_out++ = p_ctx->palette[*p_file].green;
-        *p_out++ = p_ctx->palette[*p_file].blue;
+        PutColor(p_out, p_ctx->palette[*p_file].red,
+                        p_ctx->palette[*p_file].green,
+                        p_ctx->palette[*p_file].blue, p_ctx);
         if(p_ctx->out_channels == 4)
             *p_out++ = BMPREAD_DEFAULT_ALPHA;
 
@@ -763,9 +804,9 @@ static void Decode4(uint8_t * p_out,
     {
         unsigned int lookup = (*p_file & 0xf0U) >> 4;
 
-        *p_out++ = p_ctx->palette[lookup].red;
-        *p_out++ = p_ctx->palette[lookup].green;
-        *p_out++ = p_ctx->palette[lookup].blue;
+        PutColor(p_out, p_ctx->palette[lookup].red,
+                        p_ctx->palette[lookup].green,
+                        p_ctx->palette[lookup].blue, p_ctx);
         if(p_ctx->out_channels == 4)
             *p_out++ = BMPREAD_DEFAULT_ALPHA;
 
@@ -773,9 +814,9 @@ static void Decode4(uint8_t * p_out,
         {
             lookup = *p_file++ & 0x0fU;
 
-            *p_out++ = p_ctx->palette[lookup].red;
-            *p_out++ = p_ctx->palette[lookup].green;
-            *p_out++ = p_ctx->palette[lookup].blue;
+            PutColor(p_out, p_ctx->palette[lookup].red,
+                            p_ctx->palette[lookup].green,
+                            p_ctx->palette[lookup].blue, p_ctx);
             if(p_ctx->out_channels == 4)
                 *p_out++ = BMPREAD_DEFAULT_ALPHA;
         }
@@ -796,9 +837,9 @@ static void Decode1(uint8_t * p_out,
         {
             unsigned int lookup = (*p_file >> (7 - bit)) & 1;
 
-            *p_out++ = p_ctx->palette[lookup].red;
-            *p_out++ = p_ctx->palette[lookup].green;
-            *p_out++ = p_ctx->palette[lookup].blue;
+            PutColor(p_out, p_ctx->palette[lookup].red,
+                            p_ctx->palette[lookup].green,
+                            p_ctx->palette[lookup].blue, p_ctx);
             if(p_ctx->out_channels == 4)
                 *p_out++ = BMPREAD_DEFAULT_ALPHA;
         }
@@ -807,6 +848,54 @@ static void Decode1(uint8_t * p_out,
     }
 }
 
+/* BMPREAD_BGRA fast path for 32-bit data in the standard X8R8G8B8 or
+ * A8R8G8B8 layout: file bytes are already in output order, so copy the line
+ * and only fill in alpha when it isn't taken from the file.
+ */
+static void Decode32Copy(uint8_t * p_out,
+                         const uint8_t * p_out_end,
+                         const uint8_t * p_file,
+                         const read_context * p_ctx)
+{
+    memcpy(p_out, p_file, (size_t)(p_out_end - p_out));
+    if(!(p_ctx->flags & BMPREAD_ALPHA) || !p_ctx->bitfields[3].span)
+    {
+        for(p_out += 3; p_out < p_out_end; p_out += 4)
+            *p_out = BMPREAD_DEFAULT_ALPHA;
+    }
+}
+
+/* BMPREAD_BGRA fast path for 24-bit data: copy each pixel and append alpha.
+ */
+static void Decode24Copy(uint8_t * p_out,
+                         const uint8_t * p_out_end,
+                         const uint8_t * p_file,
+                         const read_context * p_ctx)
+{
+    (void)p_ctx;
+    while(p_out < p_out_end)
+    {
+        p_out[0] = p_file[0];
+        p_out[1] = p_file[1];
+        p_out[2] = p_file[2];
+        p_out[3] = BMPREAD_DEFAULT_ALPHA;
+
+        p_out  += 4;
+        p_file += 3;
+    }
+}
+
+/* Returns whether 32-bit data is laid out as B, G, R, (A) bytes.
+ */
+static int IsStandard32(const read_context * p_ctx)
+{
+    const bitfield * bf = p_ctx->bitfields;
+    return bf[0].start == 16 && bf[0].span == 8 &&
+           bf[1].start ==  8 && bf[1].span == 8 &&
+           bf[2].start ==  0 && bf[2].span == 8 &&
+           (bf[3].span == 0 || (bf[3].start == 24 && bf[3].span == 8));
+}
+
 /* Selects an above decoder and runs it for each scan line of the file.
  * Returns 0 if there's an error or 1 if it's gravy.
  */
@@ -868,6 +957,14 @@ static int Decode(read_context * p_ctx)
         default: return 0;
     }
 
+    if(p_ctx->flags & BMPREAD_BGRA)
+    {
+        if(p_ctx->info.bits == 32 && IsStandard32(p_ctx))
+            decoder = Decode32Copy;
+        else if(p_ctx->info.bits == 24)
+            decoder = Decode24Copy;
+    }
+
     if(!CanMakeLong(p_ctx->header.data_offset))               return 0;
     if(fseek(p_ctx->fp, p_ctx->header.data_offset, SEEK_SET)) return 0;
 
@@ -24,6 +24,9 @@
 /* bmpread.h
  * version 3.0
  * 2018-02-02
+ *
+ * ALTERED SOURCE for RayWhen; this is not the original libbmpread.  Adds
+ * BMPREAD_BGRA and support for uncompressed 16/32-bit files (see bmpread.c).
  */
 
 
@@ -51,6 +54,12 @@ extern "C"
 /* Load and output an alpha channel (default is just color channels). */
 #define BMPREAD_ALPHA 8u
 
+/* Output four bytes per pixel in blue, green, red, alpha order, which is a
+ * little-endian 0xAARRGGBB word (RayWhen's framebuffer format).  Alpha is
+ * BMPREAD_DEFAULT_ALPHA unless BMPREAD_ALPHA is also set.
+ */
+#define BMPREAD_BGRA 16u
+
 
 /* The struct filled by bmpread().  Holds information about the image's pixels.
  */
@@ -69,7 +78,8 @@ typedef struct bmpread_t
      * By default, each pixel spans three bytes: the red, green, and blue color
      * components in that order.  However, with BMPREAD_ALPHA set in flags,
      * each pixel spans four bytes: the red, green, blue, and alpha components
-     * in that order.
+     * in that order.  With BMPREAD_BGRA, each pixel spans four bytes: blue,
+     * green, red, and alpha, in that order.
      *
      * Pixels are ordered left to right sequentially.  By default, the bottom
      * line comes first, proceeding upward.  However, with BMPREAD_TOP_DOWN set
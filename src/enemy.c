@@ -1,5 +1,6 @@
 #include "enemy.h"
 #include "player.h"
+#include "raycast.h"
 #include "raywhen.h"
 
 // External enemy array
@@ -26,8 +27,10 @@ void addEnemy(double x, double y) {
 
 // Simple hitscan at crosshair against all enemies
 void shootAtCrosshair(void) {
-    int centerX = SCREEN_WIDTH / 2;
-    double wallDist = depthBuffer ? depthBuffer[centerX] : 1e9;
+    // Enemies under the crosshair, in array order
+    int candidates[MAX_ENEMIES];
+    double candidateDist[MAX_ENEMIES], rayDirX[MAX_ENEMIES], rayDirY[MAX_ENEMIES];
+    int count = 0;
     
     for (int i = 0; i < numEnemies; i++) {
         if (!enemies[i].alive) continue;
@@ -49,35 +52,54 @@ void shootAtCrosshair(void) {
         double aimTolerance = halfWidth * 1.6;
 
         // Check if within FOV and aiming tolerance
-        if (fabs(rel) <= aimTolerance && dist < wallDist) {
-            enemies[i].health -= 1;
-            if (enemies[i].health <= 0) enemies[i].alive = 0;
-            break; // Only hit one enemy per shot
+        if (fabs(rel) <= aimTolerance) {
+            candidates[count] = i;
+            candidateDist[count] = dist;
+            rayDirX[count] = dx / dist;
+            rayDirY[count] = dy / dist;
+            ++count;
         }
     }
+    if (count == 0) return;
+
+    // Line of sight to each candidate as one batch of unit rays, so the
+    // wall distance is Euclidean like dist
+    double hitDistance[MAX_ENEMIES], hitWallX[MAX_ENEMIES];
+    int hitWallType[MAX_ENEMIES], hitSide[MAX_ENEMIES], hitTexture[MAX_ENEMIES];
+    int hitMapX[MAX_ENEMIES], hitMapY[MAX_ENEMIES];
+    const RayHits hits = { hitDistance, hitWallX, hitWallType, hitSide, hitTexture, hitMapX, hitMapY };
+    castRays(playerX, playerY, rayDirX, rayDirY, count, &hits);
+
+    for (int c = 0; c < count; c++) {
+        if (hitMapX[c] >= 0 && hitDistance[c] <= candidateDist[c]) continue; // Behind a wall
+        Enemy *e = &enemies[candidates[c]];
+        e->health -= 1;
+        if (e->health <= 0) e->alive = 0;
+        break; // Only hit one enemy per shot
+    }
 }
 
-void renderEnemies(void) {
+void renderEnemies(const Framebuffer *fb) {
     // Render all enemies as billboard sprites, depth-tested against walls
     for (int i = 0; i < numEnemies; i++) {
         if (!enemies[i].alive) continue;
         
         double dx = enemies[i].x - playerX;
         double dy = enemies[i].y - playerY;
-        double dist = sqrt(dx*dx + dy*dy);
+        // Camera space: depth along the view direction and lateral offset,
+        // matching the walls' camera-plane projection
+        double dirX = cos(playerAngle), dirY = sin(playerAngle);
+        double dist = dx * dirX + dy * dirY;
+        double lateral = dy * dirX - dx * dirY;
         if (dist > 0.001) {
-            double angleToEnemy = atan2(dy, dx);
-            double rel = angleToEnemy - playerAngle;
-            // Normalize to [-pi,pi]
-            while (rel < -M_PI) rel += 2*M_PI;
-            while (rel >  M_PI) rel -= 2*M_PI;
-            // Only render if within FOV
-            if (fabs(rel) < (FOV * 0.6)) {
-                int spriteScreenX = (int)((rel + FOV/2) / FOV * SCREEN_WIDTH);
+            double planeScale = tan(FOV / 2.0);
+            // Only render if within FOV (with a margin for the sprite's width)
+            if (fabs(lateral / dist) < planeScale * 1.2 + enemies[i].radius / dist) {
+                int spriteScreenX = (int)((1.0 + lateral / (dist * planeScale)) * 0.5 * fb->width);
                 // Projected size (simple) and vertical placement centered around horizon
-                int spriteH = (int)(SCREEN_HEIGHT / dist);
+                int spriteH = (int)(fb->height / dist);
                 int spriteW = spriteH; // square billboard
-                int horizon = SCREEN_HEIGHT / 2 + (int)pitchOffset;
+                int horizon = fb->height / 2 + (int)pitchOffset;
                 int top = horizon - spriteH/2;
                 int left = spriteScreenX - spriteW/2;
                 // Simple color and shading by distance
@@ -85,17 +107,17 @@ void renderEnemies(void) {
                 // Draw with depth test
                 for (int sx = 0; sx < spriteW; ++sx) {
                     int xOnScreen = left + sx;
-                    if (xOnScreen < 0 || xOnScreen >= SCREEN_WIDTH) continue;
+                    if (xOnScreen < 0 || xOnScreen >= fb->width) continue;
                     // Occlusion: only draw if enemy in front of wall at this column
                     if (depthBuffer && dist >= depthBuffer[xOnScreen]) continue;
                     for (int sy = 0; sy < spriteH; ++sy) {
                         int yOnScreen = top + sy;
-                        if (yOnScreen < 0 || yOnScreen >= SCREEN_HEIGHT) continue;
+                        if (yOnScreen < 0 || yOnScreen >= fb->height) continue;
                         // Simple circular mask inside the rectangle to look less boxy
                         double nx = (sx - spriteW/2) / (double)(spriteW/2);
                         double ny = (sy - spriteH/2) / (double)(spriteH/2);
                         if (nx*nx + ny*ny > 1.0) continue;
-                        backPixels[yOnScreen * SCREEN_WIDTH + xOnScreen] = base;
+                        fb->pixels[yOnScreen * fb->stride + xOnScreen] = base;
                     }
                 }
             }
@@ -2,6 +2,7 @@
 #define ENEMY_H
 
 #include "raywhen.h"
+#include "framebuffer.h"
 
 // Enemy structure
 typedef struct {
@@ -22,6 +23,6 @@ extern int numEnemies;
 void resetEnemies(void);
 void addEnemy(double x, double y);
 void shootAtCrosshair(void);
-void renderEnemies(void);
+void renderEnemies(const Framebuffer *fb);
 
 #endif // ENEMY_H
@@ -0,0 +1,133 @@
+#include "framebuffer.h"
+
+#include <ctype.h>
+
+// Depth buffer for sprite occlusion (stores corrected distances for each screen column)
+double *depthBuffer = NULL;
+int depthW = 0;
+
+// Allocate an in-memory framebuffer (used by the headless front end)
+int framebufferCreate(Framebuffer *fb, int width, int height) {
+    if (!fb || width <= 0 || height <= 0) return 0;
+    fb->pixels = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)width * (size_t)height);
+    if (!fb->pixels) {
+        fb->width = fb->height = fb->stride = 0;
+        fb->owned = 0;
+        return 0;
+    }
+    fb->width = width;
+    fb->height = height;
+    fb->stride = width;
+    fb->owned = 1;
+    return 1;
+}
+
+// Describe memory owned by someone else (e.g. the GDI DIB section)
+void framebufferWrap(Framebuffer *fb, uint32_t *pixels, int width, int height, int stride) {
+    if (!fb) return;
+    fb->pixels = pixels;
+    fb->width = width;
+    fb->height = height;
+    fb->stride = stride;
+    fb->owned = 0;
+}
+
+void framebufferDestroy(Framebuffer *fb) {
+    if (!fb) return;
+    if (fb->owned && fb->pixels) free(fb->pixels);
+    fb->pixels = NULL;
+    fb->width = fb->height = fb->stride = 0;
+    fb->owned = 0;
+}
+
+// Next header number of a binary PPM, skipping whitespace and comments
+static int readPPMNumber(FILE *f) {
+    int c = fgetc(f);
+    while (c == '#' || isspace(c)) {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) c = fgetc(f);
+        }
+        c = fgetc(f);
+    }
+    int value = 0, digits = 0;
+    while (c >= '0' && c <= '9' && digits < 9) {
+        value = value * 10 + (c - '0');
+        digits++;
+        c = fgetc(f);
+    }
+    // The single whitespace byte after the number is consumed here
+    return digits ? value : -1;
+}
+
+// Load a binary (P6, 8-bit) PPM into a newly allocated framebuffer
+int framebufferReadPPM(Framebuffer *fb, const char *path) {
+    if (!fb || !path) return 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    int ok = fgetc(f) == 'P' && fgetc(f) == '6';
+    int width = ok ? readPPMNumber(f) : -1;
+    int height = ok ? readPPMNumber(f) : -1;
+    int maxValue = ok ? readPPMNumber(f) : -1;
+    if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || maxValue != 255 ||
+        !framebufferCreate(fb, width, height)) {
+        fclose(f);
+        return 0;
+    }
+    unsigned char *line = (unsigned char*)malloc((size_t)width * 3);
+    if (!line) ok = 0;
+    for (int y = 0; y < height && ok; ++y) {
+        uint32_t *row = fb->pixels + y * fb->stride;
+        if (fread(line, 3, width, f) != (size_t)width) ok = 0;
+        for (int x = 0; x < width && ok; ++x) {
+            row[x] = ((uint32_t)line[x * 3 + 0] << 16) | ((uint32_t)line[x * 3 + 1] << 8) | line[x * 3 + 2];
+        }
+    }
+    free(line);
+    fclose(f);
+    if (!ok) framebufferDestroy(fb);
+    return ok;
+}
+
+// (Re)allocate depth buffer to match the given width
+int ensureDepthBuffer(int width) {
+    if (depthBuffer && depthW == width) return 1;
+    freeDepthBuffer();
+    depthBuffer = (double*)malloc(sizeof(double) * width);
+    if (!depthBuffer) return 0;
+    depthW = width;
+    return 1;
+}
+
+void freeDepthBuffer(void) {
+    if (depthBuffer) {
+        free(depthBuffer);
+        depthBuffer = NULL;
+    }
+    depthW = 0;
+}
+
+// Write the framebuffer as a binary PPM (P6) image
+int framebufferWritePPM(const Framebuffer *fb, const char *path) {
+    if (!fb || !fb->pixels || !path) return 0;
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "P6\n%d %d\n255\n", fb->width, fb->height);
+    unsigned char *line = (unsigned char*)malloc((size_t)fb->width * 3);
+    if (!line) {
+        fclose(f);
+        return 0;
+    }
+    int ok = 1;
+    for (int y = 0; y < fb->height && ok; ++y) {
+        const uint32_t *row = fb->pixels + y * fb->stride;
+        for (int x = 0; x < fb->width; ++x) {
+            line[x * 3 + 0] = (unsigned char)(row[x] >> 16);
+            line[x * 3 + 1] = (unsigned char)(row[x] >> 8);
+            line[x * 3 + 2] = (unsigned char)(row[x]);
+        }
+        if (fwrite(line, 3, fb->width, f) != (size_t)fb->width) ok = 0;
+    }
+    free(line);
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,25 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "raywhen.h"
+
+// Platform-independent render target the software renderer draws into.
+// Pixels are BGRA, top-down; stride is in pixels and may exceed width.
+typedef struct {
+    int width;
+    int height;
+    int stride;
+    uint32_t *pixels;
+    int owned; // pixels were allocated by framebufferCreate()
+} Framebuffer;
+
+// Function declarations
+int framebufferCreate(Framebuffer *fb, int width, int height);
+void framebufferWrap(Framebuffer *fb, uint32_t *pixels, int width, int height, int stride);
+void framebufferDestroy(Framebuffer *fb);
+int framebufferWritePPM(const Framebuffer *fb, const char *path);
+int framebufferReadPPM(Framebuffer *fb, const char *path);
+int ensureDepthBuffer(int width);
+void freeDepthBuffer(void);
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,212 @@
+// Golden-image regression harness: renders a fixed set of viewpoints from
+// the shipped maps (and a v2 fixture) without a window and compares each frame against the
+// reference PPM checked in under golden/. Every channel of every pixel must
+// be within the tolerance; for each view that fails, the rendered frame
+// and a diff image (out-of-tolerance pixels in red over a dimmed copy of
+// the reference) are written to the output directory.
+#include "raywhen.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "texstore.h"
+#include "map.h"
+#include "player.h"
+#include "enemy.h"
+#include "renderer.h"
+#include "threadpool.h"
+#include "raster.h"
+
+// Reference frames are small so the checked-in files stay small
+#define GOLDEN_WIDTH 320
+#define GOLDEN_HEIGHT 240
+
+// Global screen dimensions (fixed for the whole run)
+int SCREEN_WIDTH = GOLDEN_WIDTH;
+int SCREEN_HEIGHT = GOLDEN_HEIGHT;
+
+typedef struct {
+    const char *name;   // reference file is <name>.ppm
+    const char *map;
+    double x, y, angle, pitch;
+    int perf;           // simple shading mode
+} GoldenView;
+
+// Cover every pass: near and far walls on both sides, enemies, floor and
+// sky with the horizon moved both ways, and performance mode
+static const GoldenView goldenViews[] = {
+    { "arena_pillars",      "maps/arena.rwm",       8.5, 14.5, -M_PI / 2.0,   0.0, 0 },
+    { "arena_enemy",        "maps/arena.rwm",       1.5,  2.5,  1.25,        0.0, 0 },
+    { "arena_look_down",    "maps/arena.rwm",       7.5, 13.5, -2.2,      -120.0, 0 },
+    { "arena_perf",         "maps/arena.rwm",       8.5, 14.5, -M_PI / 2.0,   0.0, 1 },
+    { "map_open_look_up",   "maps/map.rwm",         8.0,  8.0,  0.3,        90.0, 0 },
+    { "littlehouse_outside","maps/littlehouse.rwm", 4.5, 12.5,  0.1,         0.0, 0 },
+    { "littlehouse_inside", "maps/littlehouse.rwm",11.5, 11.5,  M_PI * 0.75, 20.0, 0 },
+    { "littlehouse_perf",   "maps/littlehouse.rwm", 4.5, 12.5,  0.1,         0.0, 1 },
+    // Version 2 fixture (tools/rwm_format.py): RLE planes in two row
+    // chunks, wall and floor textures named in TEXN, ENTS spawns
+    { "courtyard_v2_north", "golden/maps/courtyard.rwm", 12.5, 70.5, -M_PI / 2.0, 0.0, 0 },
+    { "courtyard_v2_south", "golden/maps/courtyard.rwm",  3.5, 45.5,  1.2,       -40.0, 0 }
+};
+#define GOLDEN_VIEW_COUNT (int)(sizeof(goldenViews) / sizeof(goldenViews[0]))
+
+static void renderView(const GoldenView *view, const Framebuffer *fb) {
+    playerX = view->x;
+    playerY = view->y;
+    playerAngle = view->angle;
+    pitchOffset = view->pitch;
+    simpleShadingMode = view->perf;
+    renderScene(fb);
+}
+
+// Count pixels with any channel further than tolerance from the reference
+// and build the diff image; returns -1 if the sizes differ
+static long comparePixels(const Framebuffer *frame, const Framebuffer *ref, int tolerance,
+                          const Framebuffer *diff, int *maxDelta) {
+    if (frame->width != ref->width || frame->height != ref->height) return -1;
+    long bad = 0;
+    *maxDelta = 0;
+    for (int y = 0; y < ref->height; ++y) {
+        const uint32_t *a = frame->pixels + y * frame->stride;
+        const uint32_t *b = ref->pixels + y * ref->stride;
+        uint32_t *d = diff->pixels + y * diff->stride;
+        for (int x = 0; x < ref->width; ++x) {
+            int delta = 0;
+            for (int shift = 0; shift < 24; shift += 8) {
+                int c = abs((int)((a[x] >> shift) & 0xFF) - (int)((b[x] >> shift) & 0xFF));
+                if (c > delta) delta = c;
+            }
+            if (delta > *maxDelta) *maxDelta = delta;
+            if (delta > tolerance) {
+                d[x] = 0x00FF0000u; // red
+                bad++;
+            } else {
+                d[x] = (b[x] >> 2) & 0x003F3F3Fu;
+            }
+        }
+    }
+    return bad;
+}
+
+static void printUsage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -ref <dir>        Reference images (default golden)\n");
+    printf("  -out <dir>        Where failing frames and diffs go (default dist/golden)\n");
+    printf("  -tolerance <n>    Allowed per-channel difference, 0-255 (default 0)\n");
+    printf("  -update           Rewrite the references from this build\n");
+    printf("  -threads <n>      Render threads (0 = one per CPU, default 1)\n");
+    printf("  -simd <path>      Force SIMD kernels: scalar, sse2 or avx2 (default: best spans, scalar rays)\n");
+    printf("  -pack <file.rwp>  Texture pack to map (default %s if present)\n", DEFAULT_TEXTURE_PACK);
+    printf("  -no-pack          Decode textures from assets/ even if a pack exists\n");
+}
+
+int main(int argc, char **argv) {
+    const char *refDir = "golden";
+    const char *outDir = "dist/golden";
+    const char *simdPath = NULL;
+    int tolerance = 0;
+    int update = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-ref") == 0 && next) {
+            refDir = next; i++;
+        } else if (strcmp(arg, "-out") == 0 && next) {
+            outDir = next; i++;
+        } else if (strcmp(arg, "-tolerance") == 0 && next) {
+            tolerance = atoi(next); i++;
+            if (tolerance < 0) tolerance = 0;
+            if (tolerance > 255) tolerance = 255;
+        } else if (strcmp(arg, "-update") == 0) {
+            update = 1;
+        } else if ((strcmp(arg, "-threads") == 0 || strcmp(arg, "--threads") == 0) && next) {
+            int n = atoi(next); i++;
+            if (n >= 0 && n <= MAX_RENDER_THREADS) renderThreadCount = n;
+        } else if (strcmp(arg, "-simd") == 0 && next) {
+            simdPath = next; i++;
+        } else if (strcmp(arg, "-pack") == 0 && next) {
+            texturePackPath = next; i++;
+        } else if (strcmp(arg, "-no-pack") == 0) {
+            texturePackPath = NULL;
+        } else if (strcmp(arg, "-help") == 0 || strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    threadPoolInit(renderThreadCount);
+    rasterInit();
+    if (simdPath && !rasterSelect(simdPath)) {
+        fprintf(stderr, "Span kernels '%s' not available on this CPU\n", simdPath);
+        return 1;
+    }
+
+    Framebuffer frame, diff;
+    if (!framebufferCreate(&frame, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !framebufferCreate(&diff, SCREEN_WIDTH, SCREEN_HEIGHT) || !ensureDepthBuffer(SCREEN_WIDTH)) {
+        fprintf(stderr, "Out of memory allocating %dx%d framebuffer\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        return 1;
+    }
+
+    printf("Span kernels: %s, threads: %d, tolerance: %d\n", rasterPathName(), threadPoolSize(), tolerance);
+    int failures = 0;
+    const char *loadedMap = NULL;
+    for (int v = 0; v < GOLDEN_VIEW_COUNT; ++v) {
+        const GoldenView *view = &goldenViews[v];
+        char path[MAX_PATH];
+
+        if (!loadedMap || strcmp(loadedMap, view->map) != 0) {
+            if (!loadMapFromFile(view->map)) {
+                fprintf(stderr, "Failed to load map: %s\n", view->map);
+                failures++;
+                continue;
+            }
+            loadedMap = view->map;
+        }
+        renderView(view, &frame);
+
+        snprintf(path, sizeof(path), "%s/%s.ppm", refDir, view->name);
+        if (update) {
+            int ok = framebufferWritePPM(&frame, path);
+            printf("%-22s %s\n", view->name, ok ? "updated" : "FAILED to write");
+            if (!ok) failures++;
+            continue;
+        }
+
+        Framebuffer ref;
+        if (!framebufferReadPPM(&ref, path)) {
+            printf("%-22s FAIL  missing or unreadable reference %s\n", view->name, path);
+            failures++;
+            continue;
+        }
+        int maxDelta = 0;
+        long bad = comparePixels(&frame, &ref, tolerance, &diff, &maxDelta);
+        if (bad == 0) {
+            printf("%-22s ok    max delta %d\n", view->name, maxDelta);
+        } else if (bad < 0) {
+            printf("%-22s FAIL  reference is %dx%d, expected %dx%d\n", view->name,
+                   ref.width, ref.height, frame.width, frame.height);
+            failures++;
+        } else {
+            printf("%-22s FAIL  %ld pixels over tolerance, max delta %d\n", view->name, bad, maxDelta);
+            snprintf(path, sizeof(path), "%s/%s.ppm", outDir, view->name);
+            int ok = framebufferWritePPM(&frame, path);
+            snprintf(path, sizeof(path), "%s/%s.diff.ppm", outDir, view->name);
+            ok = framebufferWritePPM(&diff, path) && ok;
+            if (!ok) fprintf(stderr, "  could not write frame/diff to %s\n", outDir);
+            failures++;
+        }
+        framebufferDestroy(&ref);
+    }
+
+    if (!update) printf("%d of %d views passed\n", GOLDEN_VIEW_COUNT - failures, GOLDEN_VIEW_COUNT);
+
+    framebufferDestroy(&frame);
+    framebufferDestroy(&diff);
+    freeDepthBuffer();
+    threadPoolShutdown();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+// Headless front end: renders frames from a map into an in-memory
+// framebuffer without creating a window, for benchmarking and profiling
+// the software renderer on build machines.
+#include "raywhen.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "texstore.h"
+#include "texstream.h"
+#include "texcache.h"
+#include "map.h"
+#include "player.h"
+#include "enemy.h"
+#include "renderer.h"
+#include "threadpool.h"
+#include "raster.h"
+#include "raycache.h"
+#include "profiler.h"
+
+// Global screen dimensions (fixed for the whole run)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+static void printUsage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -map <file>      Map to load (.rwm or .txt)\n");
+    printf("  -w <width>       Framebuffer width (default %d)\n", DEFAULT_SCREEN_WIDTH);
+    printf("  -h <height>      Framebuffer height (default %d)\n", DEFAULT_SCREEN_HEIGHT);
+    printf("  -frames <n>      Number of frames to render (default 100)\n");
+    printf("  -turn <radians>  Yaw added after each frame (default 0.01)\n");
+    printf("  -perf            Flat-shaded walls (performance mode)\n");
+    printf("  -threads <n>     Render threads (0 = one per CPU, default 1)\n");
+    printf("  -simd <path>     Force SIMD kernels: scalar, sse2 or avx2 (default: best spans, scalar rays)\n");
+    printf("  -raycast <mode>  Raycast arithmetic: double, float or fixed (default %s)\n", rayCastPrecisionName());
+    printf("  -ray-cache       Reuse rays while the view only turns (off by default)\n");
+    printf("  -o <file.ppm>    Write the last frame as a PPM image\n");
+    printf("  --profile-csv <file>  Write per-frame phase timings as CSV\n");
+    printf("  --texture-budget-mb <n>  Evict least recently used textures beyond n MB\n");
+    printf("  -pack <file.rwp> Texture pack to map (default %s if present)\n", DEFAULT_TEXTURE_PACK);
+    printf("  -no-pack         Decode textures from assets/ even if a pack exists\n");
+    printf("  -stream          Start on procedural placeholders, decode textures in the background\n");
+}
+
+int main(int argc, char **argv) {
+    const char *mapPath = NULL;
+    const char *outPath = NULL;
+    const char *simdPath = NULL;
+    const char *precisionName = NULL;
+    const char *profileCsvPath = NULL;
+    int frames = 100;
+    double turn = 0.01;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-map") == 0 && next) {
+            mapPath = next; i++;
+        } else if ((strcmp(arg, "-w") == 0 || strcmp(arg, "--width") == 0) && next) {
+            int w = atoi(next); i++;
+            if (w > 0 && w <= 8192) SCREEN_WIDTH = w;
+        } else if ((strcmp(arg, "-h") == 0 || strcmp(arg, "--height") == 0) && next) {
+            int h = atoi(next); i++;
+            if (h > 0 && h <= 8192) SCREEN_HEIGHT = h;
+        } else if (strcmp(arg, "-frames") == 0 && next) {
+            frames = atoi(next); i++;
+            if (frames < 1) frames = 1;
+        } else if (strcmp(arg, "-turn") == 0 && next) {
+            turn = atof(next); i++;
+        } else if (strcmp(arg, "-perf") == 0 || strcmp(arg, "--performance") == 0) {
+            simpleShadingMode = 1;
+            perfExplicitlySet = 1;
+        } else if (strcmp(arg, "--no-perf") == 0) {
+            simpleShadingMode = 0;
+            perfExplicitlySet = 1;
+        } else if ((strcmp(arg, "-threads") == 0 || strcmp(arg, "--threads") == 0) && next) {
+            int n = atoi(next); i++;
+            if (n >= 0 && n <= MAX_RENDER_THREADS) renderThreadCount = n;
+        } else if (strcmp(arg, "-simd") == 0 && next) {
+            simdPath = next; i++;
+        } else if (strcmp(arg, "-raycast") == 0 && next) {
+            precisionName = next; i++;
+        } else if (strcmp(arg, "-pack") == 0 && next) {
+            texturePackPath = next; i++;
+        } else if (strcmp(arg, "-ray-cache") == 0) {
+            rayCacheEnabled = 1;
+        } else if (strcmp(arg, "-no-pack") == 0) {
+            texturePackPath = NULL;
+        } else if (strcmp(arg, "-stream") == 0) {
+            textureStreaming = 1;
+        } else if (strcmp(arg, "-o") == 0 && next) {
+            outPath = next; i++;
+        } else if (strcmp(arg, "--profile-csv") == 0 && next) {
+            profileCsvPath = next; i++;
+        } else if (strcmp(arg, "--texture-budget-mb") == 0 && next) {
+            int mb = atoi(next); i++;
+            if (mb >= 0) textureBudgetBytes = (size_t)mb * 1024 * 1024;
+        } else if (strcmp(arg, "-help") == 0 || strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Start the pool first: map loading decodes textures on it
+    threadPoolInit(renderThreadCount);
+    double loadStart = profilerNow();
+    if (mapPath && !loadMapFromFile(mapPath)) {
+        fprintf(stderr, "Failed to load map: %s\n", mapPath);
+        return 1;
+    }
+    double loadMs = profilerNow() - loadStart;
+
+    rasterInit();
+    if (simdPath && !rasterSelect(simdPath)) {
+        fprintf(stderr, "Span kernels '%s' not available on this CPU\n", simdPath);
+        return 1;
+    }
+    if (precisionName && !rayCastPrecisionSelect(precisionName)) {
+        fprintf(stderr, "Unknown raycast arithmetic '%s'\n", precisionName);
+        return 1;
+    }
+
+    Framebuffer fb;
+    if (!framebufferCreate(&fb, SCREEN_WIDTH, SCREEN_HEIGHT) || !ensureDepthBuffer(SCREEN_WIDTH)) {
+        fprintf(stderr, "Out of memory allocating %dx%d framebuffer\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        return 1;
+    }
+
+    if (profileCsvPath && !profilerOpenCsv(profileCsvPath)) {
+        fprintf(stderr, "Failed to open %s\n", profileCsvPath);
+        return 1;
+    }
+
+    double minMs = 1e30, maxMs = 0.0;
+    double firstFrameMs = 0.0;
+    int streamingAtFirstFrame = 0;
+    double start = profilerNow();
+    for (int i = 0; i < frames; ++i) {
+        double t0 = profilerNow();
+        renderScene(&fb);
+        double dt = profilerNow() - t0;
+        if (i == 0) {
+            firstFrameMs = profilerNow() - loadStart;
+            streamingAtFirstFrame = textureStreamPending();
+        }
+        if (dt < minMs) minMs = dt;
+        if (dt > maxMs) maxMs = dt;
+        profilerEndFrame();
+        playerAngle += turn;
+    }
+    profilerCloseCsv();
+    double total = profilerNow() - start;
+
+    printf("Map: %s\n", mapPath ? mapPath : "(built-in)");
+    printf("Map load: %.2f ms\n", loadMs);
+    printf("First frame: %.2f ms after load start", firstFrameMs);
+    if (textureStreaming) printf(" (%d textures still streaming)", streamingAtFirstFrame);
+    printf("\n");
+    printf("Resolution: %dx%d%s\n", SCREEN_WIDTH, SCREEN_HEIGHT, simpleShadingMode ? " [PERF]" : "");
+    printf("Threads: %d\n", threadPoolSize());
+    printf("Span kernels: %s, ray kernel: %s, raycast arithmetic: %s\n", rasterPathName(), rayCastKernelName(),
+           rayCastPrecisionName());
+    printf("Frames: %d\n", frames);
+    printf("Total: %.2f ms\n", total);
+    printf("Frame time: avg %.3f ms, min %.3f ms, max %.3f ms\n", total / frames, minMs, maxMs);
+    printf("Throughput: %.1f FPS, %.1f Mpixels/s\n",
+        frames * 1000.0 / total,
+        (double)SCREEN_WIDTH * SCREEN_HEIGHT * frames / (total * 1000.0));
+
+    char phases[1024];
+    profilerFormat(phases, sizeof(phases));
+    printf("Phases (last %d frames):\n%s", frames < PROFILE_WINDOW ? frames : PROFILE_WINDOW, phases);
+    char cacheLine[256];
+    textureCacheFormat(cacheLine, sizeof(cacheLine));
+    printf("%s\n", cacheLine);
+    if (texturesQuantized > 0) printf("Textures quantized to 256 colors: %d\n", texturesQuantized);
+    rayCacheFormat(cacheLine, sizeof(cacheLine));
+    printf("%s\n", cacheLine);
+
+    int ok = 1;
+    if (outPath) {
+        ok = framebufferWritePPM(&fb, outPath);
+        if (!ok) fprintf(stderr, "Failed to write %s\n", outPath);
+    }
+
+    textureStreamShutdown();
+    framebufferDestroy(&fb);
+    freeDepthBuffer();
+    threadPoolShutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include "lighting.h"
+
+// Nearest level for a brightness factor in (0, 1]
+int lightLevelForBrightness(double brightness) {
+    if (!(brightness > 0.0)) return SHADE_LEVELS - 1;
+    if (brightness >= 1.0) return 0;
+    int level = (int)(-log2(brightness) * SHADE_LEVELS_PER_HALF + 0.5);
+    if (level >= SHADE_LEVELS) level = SHADE_LEVELS - 1;
+    return level;
+}
+
+double lightLevelBrightness(int level) {
+    return pow(2.0, -(double)level / SHADE_LEVELS_PER_HALF);
+}
+
+// Walls fade linearly to 30% at MAX_DISTANCE; y-side walls sit a fixed
+// number of levels darker
+int wallLightLevel(double perpWallDist, int side) {
+    double brightness = 1.0 - (perpWallDist / MAX_DISTANCE) * 0.7;
+    if (brightness < 0.3) brightness = 0.3;
+    int level = lightLevelForBrightness(brightness);
+    if (side == 1) level += SIDE_SHADE_OFFSET;
+    if (level >= SHADE_LEVELS) level = SHADE_LEVELS - 1;
+    return level;
+}
+
+int floorLightLevel(double rowDistance) {
+    double brightness = 1.0 / (1.0 + rowDistance * 0.1);
+    if (brightness < 0.3) brightness = 0.3;
+    return lightLevelForBrightness(brightness);
+}
+
+// Fill colormap[level][i] with palette[i] (BGRA) scaled to each level
+void buildColormap(uint32_t colormap[SHADE_LEVELS][256], const uint32_t *palette, int count) {
+    for (int level = 0; level < SHADE_LEVELS; level++) {
+        uint32_t scale = (uint32_t)(lightLevelBrightness(level) * 256.0 + 0.5);
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = (i < count) ? palette[i] : 0;
+            uint32_t rb = ((c & 0x00FF00FFu) * scale >> 8) & 0x00FF00FFu;
+            uint32_t g = ((c & 0x0000FF00u) * scale >> 8) & 0x0000FF00u;
+            colormap[level][i] = rb | g | 0xFF000000u;
+        }
+    }
+}
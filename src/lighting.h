@@ -0,0 +1,24 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include "raywhen.h"
+
+// Distance lighting via precomputed colormaps. Each texture gets one BGRA
+// palette row per light level, built at load time, so the inner loops
+// just pick a level and index a table instead of multiplying channels.
+//
+// Levels are logarithmic: brightness halves every SHADE_LEVELS_PER_HALF
+// levels. That turns multiplicative darkening (such as the ~0.7x used for
+// y-side walls) into a constant level offset.
+#define SHADE_LEVELS 32
+#define SHADE_LEVELS_PER_HALF 8
+#define SIDE_SHADE_OFFSET 4    // 2^(-4/8) ~= 0.7
+
+// Function declarations
+int lightLevelForBrightness(double brightness);
+double lightLevelBrightness(int level);
+int wallLightLevel(double perpWallDist, int side);
+int floorLightLevel(double rowDistance);
+void buildColormap(uint32_t colormap[SHADE_LEVELS][256], const uint32_t *palette, int count);
+
+#endif // LIGHTING_H
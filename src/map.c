@@ -1,124 +1,463 @@
 #include "map.h"
 #include "texture.h"
+#include "texlib.h"
 #include "player.h"
 #include "enemy.h"
 
-// Enhanced map with different wall types (0 = empty, 1-4 = different wall types)
-int map[MAP_HEIGHT][MAP_WIDTH] = {
-    {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,2,2,0,0,0,0,0,0,0,0,3,3,0,1},
-    {1,0,2,2,0,0,0,0,0,0,0,0,3,3,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,4,4,4,4,4,4,0,0,0,0,1},
-    {1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1},
-    {1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1},
-    {1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1},
-    {1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1},
-    {1,0,0,0,0,4,4,0,0,4,4,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,3,3,0,0,0,0,0,0,0,0,2,2,0,1},
-    {1,0,3,3,0,0,0,0,0,0,0,0,2,2,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1}
+// Built-in level, used until a map file is loaded
+#define DEFAULT_MAP_SIZE 16
+static uint8_t defaultWalls[DEFAULT_MAP_SIZE * DEFAULT_MAP_SIZE] = {
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
+    1,0,2,2,0,0,0,0,0,0,0,0,3,3,0,1,
+    1,0,2,2,0,0,0,0,0,0,0,0,3,3,0,1,
+    1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
+    1,0,0,0,0,4,4,4,4,4,4,0,0,0,0,1,
+    1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1,
+    1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1,
+    1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1,
+    1,0,0,0,0,4,0,0,0,0,4,0,0,0,0,1,
+    1,0,0,0,0,4,4,0,0,4,4,0,0,0,0,1,
+    1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
+    1,0,3,3,0,0,0,0,0,0,0,0,2,2,0,1,
+    1,0,3,3,0,0,0,0,0,0,0,0,2,2,0,1,
+    1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
 };
+static uint16_t defaultTextures[DEFAULT_MAP_SIZE * DEFAULT_MAP_SIZE + 1];
+static uint16_t defaultFloorTextures[DEFAULT_MAP_SIZE * DEFAULT_MAP_SIZE + 1];
+// Occupancy levels of the level above (every block holds some wall)
+static uint64_t defaultOccupancy[DEFAULT_MAP_SIZE] = {
+    0xFFFF, 0x8001, 0xB00D, 0xB00D, 0x8001, 0x87E1, 0x8421, 0x8421,
+    0x8421, 0x8421, 0x8661, 0x8001, 0xB00D, 0xB00D, 0x8001, 0xFFFF
+};
+static uint8_t defaultBlocks[4 + 3] = { 1, 1, 1, 1 };
+static uint8_t defaultSuperblocks[1 + 3] = { 1 };
 
-// Texture IDs for each map cell
-int mapTextures[MAP_HEIGHT][MAP_WIDTH] = {0};
+Map map = {
+    DEFAULT_MAP_SIZE, DEFAULT_MAP_SIZE, defaultWalls, defaultTextures, defaultFloorTextures,
+    defaultOccupancy, 1, defaultBlocks, 2, defaultSuperblocks, 1
+};
 
-// Floor texture IDs for each map cell
-int mapFloorTextures[MAP_HEIGHT][MAP_WIDTH] = {0};
+unsigned int mapRevision = 0;
 
-int loadMapFromFile(const char *path) {
-    if (!path) return 0;
-    
-    // Check file extension to determine format
-    char *ext = strrchr(path, '.');
-    if (ext && strcmp(ext, ".rwm") == 0) {
-        // Load new .rwm format
-        FILE *f = fopen(path, "rb");
-        if (!f) return 0;
-        
-        // Read and verify header
-        char magic[4] = {0};
-        fread(magic, 1, 3, f);
-        if (strcmp(magic, RWM_MAGIC) != 0) {
-            fclose(f);
-            return 0;
+static void mapFree(Map *m) {
+    if (m->walls != defaultWalls) {
+        free(m->walls);
+        free(m->textures);
+        free(m->floorTextures);
+        free(m->occupancy);
+        free(m->blocks);
+        free(m->superblocks);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+// Zeroed planes for a width x height map
+static int mapAllocate(Map *m, int width, int height) {
+    memset(m, 0, sizeof(*m));
+    if (width <= 0 || height <= 0 || width > MAP_MAX_SIZE || height > MAP_MAX_SIZE) return 0;
+    size_t cells = (size_t)width * height;
+    m->width = width;
+    m->height = height;
+    m->occupancyStride = (width + 63) >> 6;
+    m->blocksWidth = (width + (1 << MAP_BLOCK_SHIFT) - 1) >> MAP_BLOCK_SHIFT;
+    m->superblocksWidth = (width + (1 << MAP_SUPERBLOCK_SHIFT) - 1) >> MAP_SUPERBLOCK_SHIFT;
+    int blocksHeight = (height + (1 << MAP_BLOCK_SHIFT) - 1) >> MAP_BLOCK_SHIFT;
+    int superblocksHeight = (height + (1 << MAP_SUPERBLOCK_SHIFT) - 1) >> MAP_SUPERBLOCK_SHIFT;
+    m->walls = (uint8_t*)calloc(cells, 1);
+    m->textures = (uint16_t*)calloc(cells + 1, sizeof(uint16_t));
+    m->floorTextures = (uint16_t*)calloc(cells + 1, sizeof(uint16_t));
+    m->occupancy = (uint64_t*)calloc((size_t)m->occupancyStride * height, sizeof(uint64_t));
+    m->blocks = (uint8_t*)calloc((size_t)m->blocksWidth * blocksHeight + 3, 1);
+    m->superblocks = (uint8_t*)calloc((size_t)m->superblocksWidth * superblocksHeight + 3, 1);
+    if (!m->walls || !m->textures || !m->floorTextures || !m->occupancy || !m->blocks || !m->superblocks) {
+        mapFree(m);
+        return 0;
+    }
+    return 1;
+}
+
+// Fill the occupancy levels from the wall plane
+static void mapBuildOccupancy(Map *m) {
+    for (int y = 0; y < m->height; ++y) {
+        const uint8_t *row = m->walls + (size_t)y * m->width;
+        uint64_t *bits = m->occupancy + (size_t)y * m->occupancyStride;
+        uint8_t *blockRow = m->blocks + (size_t)(y >> MAP_BLOCK_SHIFT) * m->blocksWidth;
+        uint8_t *superblockRow = m->superblocks + (size_t)(y >> MAP_SUPERBLOCK_SHIFT) * m->superblocksWidth;
+        for (int x = 0; x < m->width; ++x) {
+            if (!row[x]) continue;
+            bits[x >> 6] |= (uint64_t)1 << (x & 63);
+            blockRow[x >> MAP_BLOCK_SHIFT] = 1;
+            superblockRow[x >> MAP_SUPERBLOCK_SHIFT] = 1;
         }
-        
-        int version = fgetc(f);
-        if (version != RWM_VERSION) {
-            fclose(f);
+    }
+}
+
+// Make a fully parsed map the current one
+static void mapReplace(Map *m) {
+    mapBuildOccupancy(m);
+    mapFree(&map);
+    map = *m;
+    mapRevision++;
+}
+
+// Load every texture the map refers to as one batch, after parsing, so
+// the decodes run in parallel instead of one by one between cells
+static void loadMapTextures(void) {
+    uint8_t used[MAX_TEXTURES] = {0};
+    int ids[MAX_TEXTURES];
+    int count = 0;
+    size_t cells = (size_t)map.width * map.height;
+    for (size_t c = 0; c < cells; ++c) {
+        int wallId = map.textures[c];
+        int floorId = map.floorTextures[c];
+        if (wallId < MAX_TEXTURES && !used[wallId]) {
+            used[wallId] = 1;
+            ids[count++] = wallId;
+        }
+        if (floorId < MAX_TEXTURES && !used[floorId]) {
+            used[floorId] = 1;
+            ids[count++] = floorId;
+        }
+    }
+    loadTextures(ids, count);
+}
+
+// Texture id stored as a bare number (v1, .txt, v2 without TEXN). Only the
+// built-in table has fixed handles; anything past it would depend on the
+// assets installed, so it falls back to texture 0.
+static int builtinTextureId(int id) {
+    return id >= 0 && id < TEXTURE_BUILTIN_COUNT ? id : 0;
+}
+
+// Store one parsed cell: spawn markers become entities and walkable floor,
+// everything else is clamped into range
+static void setCell(Map *m, int x, int y, int wallType, int textureId, int floorTextureId) {
+    int textureLimit = textureCount();
+    if (wallType < 0) wallType = 0;
+    if (wallType > 6) wallType = 6;
+    if (textureId < 0 || textureId >= textureLimit) textureId = 0;
+    if (floorTextureId < 0 || floorTextureId >= textureLimit) floorTextureId = 0;
+    size_t c = (size_t)y * m->width + x;
+
+    if (wallType == 5) {
+        // Player spawn - set player position
+        setPlayerPosition(x + 0.5, y + 0.5);
+        m->walls[c] = 0; // Make it walkable
+    } else if (wallType == 6) {
+        // Enemy spawn - add enemy
+        addEnemy(x + 0.5, y + 0.5);
+        m->walls[c] = 0; // Make it walkable
+    } else {
+        m->walls[c] = (uint8_t)wallType;
+        m->textures[c] = (uint16_t)textureId;
+        m->floorTextures[c] = (uint16_t)floorTextureId;
+    }
+}
+
+// Whole file in one read; NULL if it cannot be read
+static uint8_t *readFile(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    long len = -1;
+    if (fseek(f, 0, SEEK_END) == 0) len = ftell(f);
+    uint8_t *data = (len >= 0 && fseek(f, 0, SEEK_SET) == 0) ? (uint8_t*)malloc((size_t)len + 1) : NULL;
+    if (data && fread(data, 1, (size_t)len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+static uint32_t readLE16(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t readLE64(const uint8_t *p) {
+    return (uint64_t)readLE32(p) | ((uint64_t)readLE32(p + 4) << 32);
+}
+
+static float readLEFloat(const uint8_t *p) {
+    uint32_t bits = readLE32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// v1: fixed header, three length-prefixed strings, 3 bytes per cell
+static int loadRwmV1(const uint8_t *data, size_t size) {
+    if (size < RWM_HEADER_SIZE) return 0;
+    int mapWidth = (int)readLE16(data + 4);
+    int mapHeight = (int)readLE16(data + 6);
+
+    // Skip metadata (name, description, author)
+    size_t pos = RWM_HEADER_SIZE;
+    for (int i = 0; i < 3; i++) {
+        if (pos >= size) return 0;
+        pos += 1 + data[pos];
+    }
+    if (pos > size || size - pos < (size_t)mapWidth * mapHeight * 3) return 0;
+
+    Map m;
+    if (!mapAllocate(&m, mapWidth, mapHeight)) return 0;
+    resetEnemies();
+    const uint8_t *cell = data + pos;
+    for (int y = 0; y < mapHeight; ++y) {
+        for (int x = 0; x < mapWidth; ++x, cell += 3) {
+            setCell(&m, x, y, cell[0], builtinTextureId(cell[1]), builtinTextureId(cell[2]));
+        }
+    }
+    mapReplace(&m);
+    return 1;
+}
+
+// RLE over elements of elemSize bytes: a control byte c < 128 is followed
+// by c + 1 literal elements, c >= 128 by one element repeated c - 126 times.
+// Returns 1 if src decodes to exactly dstSize bytes.
+static int rleDecode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize, int elemSize) {
+    size_t in = 0, out = 0;
+    while (in < srcSize) {
+        int control = src[in++];
+        if (control < 128) {
+            size_t bytes = (size_t)(control + 1) * elemSize;
+            if (srcSize - in < bytes || dstSize - out < bytes) return 0;
+            memcpy(dst + out, src + in, bytes);
+            in += bytes;
+            out += bytes;
+        } else {
+            size_t count = (size_t)(control - 126);
+            if (srcSize - in < (size_t)elemSize || dstSize - out < count * elemSize) return 0;
+            if (elemSize == 1) {
+                memset(dst + out, src[in], count);
+            } else {
+                for (size_t i = 0; i < count; i++) memcpy(dst + out + i * elemSize, src + in, elemSize);
+            }
+            in += elemSize;
+            out += count * elemSize;
+        }
+    }
+    return out == dstSize;
+}
+
+// Section payload into dst (rawSize bytes)
+static int decodeSection(const RwmSection *s, const uint8_t *data, uint8_t *dst, int elemSize) {
+    const uint8_t *src = data + s->offset;
+    if (s->encoding == RWM_ENCODING_RAW) {
+        if (s->storedSize != s->rawSize) return 0;
+        memcpy(dst, src, s->rawSize);
+        return 1;
+    }
+    if (s->encoding == RWM_ENCODING_RLE) {
+        return rleDecode(src, s->storedSize, dst, s->rawSize, elemSize);
+    }
+    return 0;
+}
+
+// Most bytes one RLE control byte and element can decode to (129 elements)
+#define RWM_RLE_MAX_EXPANSION 129
+
+// Largest rawSize accepted for a section, checked before the decode buffer
+// is sized from it: a plane chunk holds at most RWM_CHUNK_ROWS rows of
+// 16-bit ids, and other decoded sections cannot expand past what RLE can
+// produce from their stored bytes. Sections the loader never decodes get
+// 0 and do not count towards the buffer.
+static uint64_t sectionRawLimit(const RwmSection *s, uint32_t mapWidth) {
+    if (memcmp(s->tag, RWM_TAG_WALLS, 4) == 0 || memcmp(s->tag, RWM_TAG_WALL_TEXTURES, 4) == 0 ||
+        memcmp(s->tag, RWM_TAG_FLOOR_TEXTURES, 4) == 0) {
+        return (uint64_t)mapWidth * RWM_CHUNK_ROWS * sizeof(uint16_t);
+    }
+    if (memcmp(s->tag, RWM_TAG_TEXTURES, 4) == 0 || memcmp(s->tag, RWM_TAG_ENTITIES, 4) == 0) {
+        return (uint64_t)s->storedSize * RWM_RLE_MAX_EXPANSION;
+    }
+    return 0;
+}
+
+// v2: header, section table, then section payloads (see map.h)
+static int loadRwmV2(const uint8_t *data, size_t size) {
+    if (size < RWM_V2_HEADER_SIZE) return 0;
+    uint32_t mapWidth = readLE32(data + 4);
+    uint32_t mapHeight = readLE32(data + 8);
+    uint32_t sectionCount = readLE32(data + 12);
+    if (mapWidth == 0 || mapHeight == 0 || mapWidth > MAP_MAX_SIZE || mapHeight > MAP_MAX_SIZE) return 0;
+    if (sectionCount > (size - RWM_V2_HEADER_SIZE) / RWM_SECTION_SIZE) return 0;
+
+    RwmSection *sections = (RwmSection*)malloc(sizeof(RwmSection) * (sectionCount ? sectionCount : 1));
+    if (!sections) return 0;
+    size_t chunkMax = 0;
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        const uint8_t *entry = data + RWM_V2_HEADER_SIZE + (size_t)i * RWM_SECTION_SIZE;
+        RwmSection *s = &sections[i];
+        memcpy(s->tag, entry, 4);
+        s->encoding = readLE32(entry + 4);
+        s->firstRow = readLE32(entry + 8);
+        s->rowCount = readLE32(entry + 12);
+        s->offset = readLE64(entry + 16);
+        s->storedSize = readLE32(entry + 24);
+        s->rawSize = readLE32(entry + 28);
+        if (s->offset > size || s->storedSize > size - s->offset) {
+            free(sections);
             return 0;
         }
-        
-        int mapWidth = fgetc(f) | (fgetc(f) << 8);
-        int mapHeight = fgetc(f) | (fgetc(f) << 8);
-        
-        if (mapWidth != MAP_WIDTH || mapHeight != MAP_HEIGHT) {
-            fclose(f);
+        uint64_t rawLimit = sectionRawLimit(s, mapWidth);
+        if (rawLimit == 0) continue;
+        if (s->rawSize > rawLimit) {
+            free(sections);
             return 0;
         }
-        
-        // Read metadata (skip for now)
-        int nameLen = fgetc(f);
-        fseek(f, nameLen, SEEK_CUR);
-        int descLen = fgetc(f);
-        fseek(f, descLen, SEEK_CUR);
-        int authorLen = fgetc(f);
-        fseek(f, authorLen, SEEK_CUR);
-        
-        // Reset enemies
+        if (s->rawSize > chunkMax) chunkMax = s->rawSize;
+    }
+    uint8_t *chunk = (uint8_t*)malloc(chunkMax ? chunkMax : 1);
+    if (!chunk) {
+        free(sections);
+        return 0;
+    }
+
+    // Texture name table first: cell texture ids index it when present
+    int *textureHandles = NULL;
+    uint32_t textureNameCount = 0;
+    int ok = 1;
+    for (uint32_t i = 0; i < sectionCount && ok; i++) {
+        const RwmSection *s = &sections[i];
+        if (memcmp(s->tag, RWM_TAG_TEXTURES, 4) != 0 || textureHandles) continue;
+        ok = decodeSection(s, data, chunk, 1) && s->rawSize >= 4;
+        if (!ok) break;
+        textureNameCount = readLE32(chunk);
+        if (textureNameCount > s->rawSize - 4) {
+            ok = 0;
+            break;
+        }
+        textureHandles = (int*)malloc(sizeof(int) * (textureNameCount ? textureNameCount : 1));
+        if (!textureHandles) {
+            ok = 0;
+            break;
+        }
+        // NUL-terminated names back to back
+        size_t pos = 4;
+        for (uint32_t t = 0; t < textureNameCount && ok; t++) {
+            const uint8_t *end = (const uint8_t*)memchr(chunk + pos, '\0', s->rawSize - pos);
+            if (!end) {
+                ok = 0;
+                break;
+            }
+            textureHandles[t] = textureRegister((const char*)chunk + pos);
+            pos = (size_t)(end - chunk) + 1;
+        }
+    }
+
+    // Cell planes, a band of rows per chunk, decoded straight into the map
+    Map m;
+    memset(&m, 0, sizeof(m));
+    if (ok && !mapAllocate(&m, (int)mapWidth, (int)mapHeight)) ok = 0;
+    for (uint32_t i = 0; i < sectionCount && ok; i++) {
+        const RwmSection *s = &sections[i];
+        int plane = memcmp(s->tag, RWM_TAG_WALLS, 4) == 0 ? 0
+                  : memcmp(s->tag, RWM_TAG_WALL_TEXTURES, 4) == 0 ? 1
+                  : memcmp(s->tag, RWM_TAG_FLOOR_TEXTURES, 4) == 0 ? 2 : -1;
+        if (plane < 0) continue; // metadata, entities, precomputed data
+        int elemSize = plane == 0 ? 1 : 2;
+        if (s->firstRow > mapHeight || s->rowCount > mapHeight - s->firstRow ||
+            s->rawSize != s->rowCount * mapWidth * (uint32_t)elemSize || !decodeSection(s, data, chunk, elemSize)) {
+            ok = 0;
+            break;
+        }
+        size_t first = (size_t)s->firstRow * mapWidth;
+        size_t cells = (size_t)s->rowCount * mapWidth;
+        if (plane == 0) {
+            memcpy(m.walls + first, chunk, cells);
+            continue;
+        }
+        uint16_t *dst = (plane == 1 ? m.textures : m.floorTextures) + first;
+        for (size_t c = 0; c < cells; c++) {
+            uint32_t id = readLE16(chunk + c * 2);
+            if (textureHandles) id = id < textureNameCount ? (uint32_t)textureHandles[id] : 0;
+            else id = (uint32_t)builtinTextureId((int)id);
+            dst[c] = (uint16_t)(id < MAX_TEXTURES ? id : 0);
+        }
+    }
+
+    // Clamp every cell the same way as v1, then place the entities
+    if (ok) {
         resetEnemies();
-        
-        // Read map data
-        for (int y = 0; y < MAP_HEIGHT; ++y) {
-            for (int x = 0; x < MAP_WIDTH; ++x) {
-                int wallType = fgetc(f);
-                int textureId = fgetc(f);
-                int floorTextureId = fgetc(f);
-                
-                // Clamp values
-                if (wallType < 0) wallType = 0;
-                if (wallType > 6) wallType = 6;
-                if (textureId < 0) textureId = 0;
-                if (textureId >= 8) textureId = 0;
-                if (floorTextureId < 0) floorTextureId = 0;
-                if (floorTextureId >= 8) floorTextureId = 0;
-                
-                if (wallType == 5) {
-                    // Player spawn - set player position
-                    setPlayerPosition(x + 0.5, y + 0.5);
-                    map[y][x] = 0; // Make it walkable
-                } else if (wallType == 6) {
-                    // Enemy spawn - add enemy
-                    addEnemy(x + 0.5, y + 0.5);
-                    map[y][x] = 0; // Make it walkable
-                } else {
-                    map[y][x] = wallType;
-                    mapTextures[y][x] = textureId;
-                    mapFloorTextures[y][x] = floorTextureId;
-                    // Load textures if not already loaded
-                    loadTexture(textureId);
-                    loadTexture(floorTextureId);
+        for (int y = 0; y < m.height; ++y) {
+            for (int x = 0; x < m.width; ++x) {
+                size_t c = (size_t)y * m.width + x;
+                setCell(&m, x, y, m.walls[c], m.textures[c], m.floorTextures[c]);
+            }
+        }
+        for (uint32_t i = 0; i < sectionCount; i++) {
+            const RwmSection *s = &sections[i];
+            if (memcmp(s->tag, RWM_TAG_ENTITIES, 4) != 0 || !decodeSection(s, data, chunk, RWM_ENTITY_SIZE)) continue;
+            for (uint32_t e = 0; e + RWM_ENTITY_SIZE <= s->rawSize; e += RWM_ENTITY_SIZE) {
+                const uint8_t *rec = chunk + e;
+                uint32_t type = readLE16(rec);
+                double x = readLEFloat(rec + 4), y = readLEFloat(rec + 8);
+                if (!(x >= 0.0 && x < m.width && y >= 0.0 && y < m.height)) continue;
+                if (type == RWM_ENTITY_PLAYER) {
+                    // Heading in radians; anything else keeps the current one
+                    double angle = readLEFloat(rec + 12);
+                    setPlayerPosition(x, y);
+                    if (isfinite(angle)) playerAngle = fmod(angle, 2.0 * M_PI);
+                } else if (type == RWM_ENTITY_ENEMY) {
+                    addEnemy(x, y);
                 }
             }
         }
-        
-        fclose(f);
+        mapReplace(&m);
+    } else if (m.walls) {
+        mapFree(&m);
+    }
+
+    free(textureHandles);
+    free(chunk);
+    free(sections);
+    return ok;
+}
+
+static int loadRwm(const char *path) {
+    size_t size = 0;
+    uint8_t *data = readFile(path, &size);
+    if (!data) return 0;
+    int ok = 0;
+    if (size >= 4 && memcmp(data, RWM_MAGIC, 3) == 0) {
+        if (data[3] == RWM_VERSION) ok = loadRwmV1(data, size);
+        else if (data[3] == RWM_VERSION_2) ok = loadRwmV2(data, size);
+    }
+    free(data);
+    return ok;
+}
+
+int loadMapFromFile(const char *path) {
+    if (!path) return 0;
+    
+    // Check file extension to determine format
+    char *ext = strrchr(path, '.');
+    if (ext && strcmp(ext, ".rwm") == 0) {
+        if (!loadRwm(path)) return 0;
+        loadMapTextures();
         return 1;
     } else {
-        // Load old .txt format for backward compatibility
+        // Load old .txt format (always 16x16) for backward compatibility
         FILE *f = fopen(path, "r");
         if (!f) return 0;
+        Map m;
+        if (!mapAllocate(&m, DEFAULT_MAP_SIZE, DEFAULT_MAP_SIZE)) {
+            fclose(f);
+            return 0;
+        }
         int ok = 1;
         
         // Reset enemies
         resetEnemies();
         
-        for (int y = 0; y < MAP_HEIGHT && ok; ++y) {
-            for (int x = 0; x < MAP_WIDTH && ok; ++x) {
+        for (int y = 0; y < m.height && ok; ++y) {
+            for (int x = 0; x < m.width && ok; ++x) {
                 int wallType = 0;
                 int textureId = 0;
                 int floorTextureId = 0;
@@ -145,33 +484,12 @@ int loadMapFromFile(const char *path) {
                     }
                 }
                 
-                // Clamp values
-                if (wallType < 0) wallType = 0;
-                if (wallType > 6) wallType = 6;
-                if (textureId < 0) textureId = 0;
-                if (textureId >= 8) textureId = 0;
-                if (floorTextureId < 0) floorTextureId = 0;
-                if (floorTextureId >= 8) floorTextureId = 0;
-                
-                if (wallType == 5) {
-                    // Player spawn - set player position
-                    setPlayerPosition(x + 0.5, y + 0.5);
-                    map[y][x] = 0; // Make it walkable
-                } else if (wallType == 6) {
-                    // Enemy spawn - add enemy
-                    addEnemy(x + 0.5, y + 0.5);
-                    map[y][x] = 0; // Make it walkable
-                } else {
-                    map[y][x] = wallType;
-                    mapTextures[y][x] = textureId;
-                    mapFloorTextures[y][x] = floorTextureId;
-                    // Load textures if not already loaded
-                    loadTexture(textureId);
-                    loadTexture(floorTextureId);
-                }
+                setCell(&m, x, y, wallType, builtinTextureId(textureId), builtinTextureId(floorTextureId));
             }
         }
         fclose(f);
+        mapReplace(&m);
+        loadMapTextures();
         return ok;
     }
 }
@@ -181,9 +499,9 @@ int canMoveTo(double newX, double newY) {
     int mapX = (int)newX;
     int mapY = (int)newY;
     
-    if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT) {
+    if (!mapInside(mapX, mapY)) {
         return 0;
     }
     
-    return map[mapY][mapX] == 0;
+    return mapWall(mapX, mapY) == 0;
 }
@@ -3,25 +3,107 @@
 
 #include "raywhen.h"
 
-// RayWhen Map (.rwm) format structure
+// RayWhen Map (.rwm) format structure, version 1
 // Header: "RWM" + version (1 byte) + map width (2 bytes) + map height (2 bytes)
 // Metadata: name length (1 byte) + name + description length (1 byte) + description + author length (1 byte) + author
 // Map data: wallType (1 byte) + textureId (1 byte) + floorTextureId (1 byte) for each cell
+// Texture ids are the original 16-entry table (see texlib.h); any other
+// texture needs a v2 file with a TEXN section
+//
+// Version 2, all integers little-endian:
+// Header (20 bytes): "RWM" + version (1 byte, 2) + width (4 bytes) + height (4 bytes)
+//   + section count (4 bytes) + flags (4 bytes, 0)
+// Section table: one 32-byte RwmSection per section, then the payloads.
+// Sections, identified by tag; unknown tags are skipped:
+//   "META" name, description, author: each a 2-byte length + UTF-8 bytes
+//   "TEXN" texture names: count (4 bytes) + NUL-terminated asset paths;
+//          when present, cell texture ids index this table
+//   "WALL" wall types, 1 byte per cell, rows firstRow..firstRow+rowCount-1
+//   "WTEX" wall texture ids, 2 bytes per cell, same row banding
+//   "FTEX" floor texture ids, 2 bytes per cell, same row banding
+//   "ENTS" entities, RWM_ENTITY_SIZE bytes each: type (2 bytes) + 2 reserved
+//          + x, y, angle (32-bit floats, x and y in cells, angle in radians;
+//          a non-finite angle is ignored)
+//   "PREC" precomputed data (reserved for derived tables)
+// Cell planes come in chunks of up to RWM_CHUNK_ROWS rows, each compressed
+// on its own. RLE chunks are control bytes over elements of the plane's
+// cell size: c < 128 is followed by c + 1 literal elements, c >= 128 by
+// one element repeated c - 126 times.
 
 #define RWM_MAGIC "RWM"
 #define RWM_VERSION 1
+#define RWM_VERSION_2 2
 #define RWM_HEADER_SIZE 8  // "RWM" + version + width + height
+#define RWM_V2_HEADER_SIZE 20
+#define RWM_SECTION_SIZE 32
+#define RWM_CHUNK_ROWS 64
+#define RWM_ENTITY_SIZE 16
 
-// Enhanced map with different wall types (0 = empty, 1-4 = different wall types)
-extern int map[MAP_HEIGHT][MAP_WIDTH];
+#define RWM_TAG_METADATA "META"
+#define RWM_TAG_TEXTURES "TEXN"
+#define RWM_TAG_WALLS "WALL"
+#define RWM_TAG_WALL_TEXTURES "WTEX"
+#define RWM_TAG_FLOOR_TEXTURES "FTEX"
+#define RWM_TAG_ENTITIES "ENTS"
+#define RWM_TAG_PRECOMPUTED "PREC"
 
-// Texture IDs for each map cell
-extern int mapTextures[MAP_HEIGHT][MAP_WIDTH];
+#define RWM_ENCODING_RAW 0
+#define RWM_ENCODING_RLE 1
 
-// Floor texture IDs for each map cell
-extern int mapFloorTextures[MAP_HEIGHT][MAP_WIDTH];
+#define RWM_ENTITY_PLAYER 1
+#define RWM_ENTITY_ENEMY 2
+
+// Section table entry, as laid out in the file
+typedef struct {
+    char tag[4];
+    uint32_t encoding;   // RWM_ENCODING_*
+    uint32_t firstRow;   // cell planes: first row in this chunk
+    uint32_t rowCount;   // cell planes: rows in this chunk
+    uint64_t offset;     // payload position in the file
+    uint32_t storedSize; // payload bytes in the file
+    uint32_t rawSize;    // bytes once decoded
+} RwmSection;
+
+// Largest width or height accepted; keeps cell indices within an int
+#define MAP_MAX_SIZE 32768
+
+// Coarse occupancy levels: blocks of 8x8 and 64x64 cells
+#define MAP_BLOCK_SHIFT 3
+#define MAP_SUPERBLOCK_SHIFT 6
+
+// The level grid, sized when a map is loaded. Cells are row-major and
+// stored as planes. Both texture planes have one spare element past the
+// last cell, so a 32-bit load at any cell stays inside the allocation.
+//
+// The ray march reads only the occupancy levels: one bit per cell (set
+// for walls), then one byte per 8x8 block and per 64x64 block (nonzero if
+// any cell inside is a wall), so it can leap across empty space. Blocks
+// on the right and bottom edges may be partial. Both block levels have 3
+// spare bytes past the end for the batch caster's 32-bit gathers.
+typedef struct {
+    int width, height;
+    uint8_t *walls;          // wall type (0 = empty, 1-4 = different wall types)
+    uint16_t *textures;      // wall texture id
+    uint16_t *floorTextures; // floor texture id
+    uint64_t *occupancy;     // bit x & 63 of word y * occupancyStride + (x >> 6)
+    int occupancyStride;     // words per row
+    uint8_t *blocks;         // 8x8 blocks, row-major, blocksWidth per row
+    int blocksWidth;
+    uint8_t *superblocks;    // 64x64 blocks, row-major, superblocksWidth per row
+    int superblocksWidth;
+} Map;
+
+extern Map map;
+extern unsigned int mapRevision; // bumped every time a map replaces the current one
+
+static inline int mapInside(int x, int y) {
+    return (unsigned)x < (unsigned)map.width && (unsigned)y < (unsigned)map.height;
+}
+
+static inline int mapWall(int x, int y) {
+    return map.walls[(size_t)y * map.width + x];
+}
 
-// Function declarations
 int loadMapFromFile(const char *path);
 int canMoveTo(double newX, double newY);
 
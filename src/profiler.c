@@ -0,0 +1,133 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "profiler.h"
+
+static const char *phaseNames[PROFILE_PHASE_COUNT] = {
+    "sky", "floor", "walls", "sprites", "crosshair", "gun", "minimap",
+    "render", "blit", "movement", "frame"
+};
+
+// Timings of the frame in progress; a phase may run several times per frame
+static double phaseStart[PROFILE_PHASE_COUNT];
+static double phaseTotal[PROFILE_PHASE_COUNT];
+
+// Rolling window of completed frames
+static double history[PROFILE_WINDOW][PROFILE_PHASE_COUNT];
+static int historyNext = 0;
+static int historyCount = 0;
+
+static double lastFrameEnd = 0.0;
+static double firstBegin = 0.0; // first phase start, until a frame has ended
+static long frameIndex = 0;
+static FILE *csvFile = NULL;
+
+double profilerNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+void profileBegin(ProfilePhase phase) {
+    phaseStart[phase] = profilerNow();
+    if (firstBegin == 0.0) firstBegin = phaseStart[phase];
+}
+
+void profileEnd(ProfilePhase phase) {
+    phaseTotal[phase] += profilerNow() - phaseStart[phase];
+}
+
+// Close the current frame: store it in the window and the CSV, then reset
+void profilerEndFrame(void) {
+    double now = profilerNow();
+    phaseTotal[PROFILE_FRAME] = now - (lastFrameEnd > 0.0 ? lastFrameEnd : firstBegin);
+    lastFrameEnd = now;
+
+    memcpy(history[historyNext], phaseTotal, sizeof(phaseTotal));
+    historyNext = (historyNext + 1) % PROFILE_WINDOW;
+    if (historyCount < PROFILE_WINDOW) historyCount++;
+
+    if (csvFile) {
+        fprintf(csvFile, "%ld", frameIndex);
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+            fprintf(csvFile, ",%.4f", phaseTotal[p]);
+        }
+        fputc('\n', csvFile);
+    }
+    frameIndex++;
+    memset(phaseTotal, 0, sizeof(phaseTotal));
+}
+
+int profilerOpenCsv(const char *path) {
+    profilerCloseCsv();
+    csvFile = fopen(path, "w");
+    if (!csvFile) return 0;
+    fprintf(csvFile, "frame");
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        fprintf(csvFile, ",%s_ms", phaseNames[p]);
+    }
+    fputc('\n', csvFile);
+    return 1;
+}
+
+void profilerCloseCsv(void) {
+    if (csvFile) {
+        fclose(csvFile);
+        csvFile = NULL;
+    }
+}
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// min/avg/p99 over the rolling window; returns the number of frames in it
+int profilerStats(ProfilePhase phase, ProfileStats *stats) {
+    double samples[PROFILE_WINDOW];
+    double sum = 0.0;
+    stats->min = stats->avg = stats->p99 = 0.0;
+    if (historyCount == 0) return 0;
+    for (int i = 0; i < historyCount; i++) {
+        samples[i] = history[i][phase];
+        sum += samples[i];
+    }
+    qsort(samples, historyCount, sizeof(double), compareDouble);
+    int p99 = (historyCount * 99 + 99) / 100 - 1; // nearest-rank percentile
+    stats->min = samples[0];
+    stats->avg = sum / historyCount;
+    stats->p99 = samples[p99];
+    return historyCount;
+}
+
+const char *profilePhaseName(ProfilePhase phase) {
+    return (phase >= 0 && phase < PROFILE_PHASE_COUNT) ? phaseNames[phase] : "?";
+}
+
+// One "phase  min/avg/p99" line per phase; returns the length written
+int profilerFormat(char *buf, size_t size) {
+    size_t len = 0;
+    if (size == 0) return 0;
+    buf[0] = '\0';
+    int n = snprintf(buf, size, "%-10s %7s %7s %7s\n", "phase (ms)", "min", "avg", "p99");
+    if (n < 0 || (size_t)n >= size) return (int)strlen(buf);
+    len = (size_t)n;
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        ProfileStats stats;
+        profilerStats((ProfilePhase)p, &stats);
+        n = snprintf(buf + len, size - len, "%-10s %7.3f %7.3f %7.3f\n",
+                     phaseNames[p], stats.min, stats.avg, stats.p99);
+        if (n < 0 || (size_t)n >= size - len) break;
+        len += (size_t)n;
+    }
+    return (int)len;
+}
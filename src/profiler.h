@@ -0,0 +1,41 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raywhen.h"
+
+// Per-phase frame profiler. Phases are timed with the high-resolution
+// clock on the main thread; each frame's timings go into a rolling window
+// for the debug overlay and, optionally, one CSV line per frame.
+typedef enum {
+    PROFILE_SKY,
+    PROFILE_FLOOR,
+    PROFILE_WALLS,
+    PROFILE_SPRITES,
+    PROFILE_CROSSHAIR,
+    PROFILE_GUN,
+    PROFILE_MINIMAP,
+    PROFILE_RENDER,   // all of renderScene()
+    PROFILE_BLIT,
+    PROFILE_MOVEMENT,
+    PROFILE_FRAME,    // time since the previous frame ended
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+#define PROFILE_WINDOW 240 // frames kept for min/avg/p99
+
+typedef struct {
+    double min, avg, p99; // milliseconds
+} ProfileStats;
+
+// Function declarations
+double profilerNow(void); // milliseconds, monotonic
+void profileBegin(ProfilePhase phase);
+void profileEnd(ProfilePhase phase);
+void profilerEndFrame(void);
+int profilerOpenCsv(const char *path);
+void profilerCloseCsv(void);
+int profilerStats(ProfilePhase phase, ProfileStats *stats);
+const char *profilePhaseName(ProfilePhase phase);
+int profilerFormat(char *buf, size_t size);
+
+#endif // PROFILER_H
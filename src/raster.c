@@ -0,0 +1,215 @@
+// Inner-loop span kernels for the software renderer.
+//
+// Each kernel has a portable scalar version plus x86 SIMD versions that
+// are compiled with per-function target attributes and picked at runtime
+// by rasterInit(), so the default -O2 build still runs on any CPU. All
+// paths use the same float/integer arithmetic and produce identical output.
+// Colors come from per-texture colormaps (see lighting.h), so the kernels
+// only ever index tables; there is no per-pixel channel math.
+#include "raster.h"
+#include "raycast.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RASTER_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*FloorRowFn)(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs);
+
+// Floor pixels [x0, x1) of a row
+static void floorRowScalar(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs) {
+    const float mapW = (float)fs->mapW, mapH = (float)fs->mapH;
+    const int levelOffset = row->level * 256;
+    // Mip sizes are powers of two, so wrapping is a mask
+    const float mipSize = (float)row->mipSize;
+    const int mipMask = row->mipSize - 1;
+    for (int i = x0; i < x1; ++i) {
+        float fx = (float)i * row->stepX + row->posX;
+        float fy = (float)i * row->stepY + row->posY;
+        // Float compares also reject inf/NaN from rows at the horizon
+        if (!(fx >= 0.0f && fx < mapW && fy >= 0.0f && fy < mapH)) {
+            dst[i] = fs->fallback;
+            continue;
+        }
+        int cell = (int)fy * fs->mapW + (int)fx;
+        int base = fs->textureTexels[fs->cellTextures[cell]];
+        if (base < 0) {
+            dst[i] = fs->fallback;
+            continue;
+        }
+        int tx = (int)(fx * mipSize) & mipMask;
+        int ty = (int)(fy * mipSize) & mipMask;
+        int index = fs->texels[base + row->mipOffset + ty * row->mipSize + tx];
+        const uint32_t *colormap = (const uint32_t*)(fs->texels + base + fs->colormapDelta);
+        dst[i] = colormap[levelOffset + index];
+    }
+}
+
+#ifdef RASTER_X86
+// 4 pixels per iteration: coordinates in SSE2, table lookups scalar
+// (SSE2 has no gather)
+__attribute__((target("sse2")))
+static void floorRowSSE2(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs) {
+    const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+    const __m128 posX = _mm_set1_ps(row->posX), posY = _mm_set1_ps(row->posY);
+    const __m128 stepX = _mm_set1_ps(row->stepX), stepY = _mm_set1_ps(row->stepY);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 mapW = _mm_set1_ps((float)fs->mapW), mapH = _mm_set1_ps((float)fs->mapH);
+    const __m128 mipSize = _mm_set1_ps((float)row->mipSize);
+    const __m128i mipMask = _mm_set1_epi32(row->mipSize - 1);
+    const __m128i fallback = _mm_set1_epi32((int)fs->fallback);
+    const int levelOffset = row->level * 256;
+    int i = x0;
+    for (; i + 4 <= x1; i += 4) {
+        __m128 fi = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), lanes));
+        __m128 fx = _mm_add_ps(_mm_mul_ps(fi, stepX), posX);
+        __m128 fy = _mm_add_ps(_mm_mul_ps(fi, stepY), posY);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, mapW)),
+                                   _mm_and_ps(_mm_cmpge_ps(fy, zero), _mm_cmplt_ps(fy, mapH)));
+        int insideBits = _mm_movemask_ps(inside);
+        if (insideBits == 0) {
+            _mm_storeu_si128((__m128i*)(dst + i), fallback);
+            continue;
+        }
+        // Zero the lanes outside the map before converting to int
+        fx = _mm_and_ps(fx, inside);
+        fy = _mm_and_ps(fy, inside);
+        int mx[4], my[4], tx[4], ty[4];
+        _mm_storeu_si128((__m128i*)mx, _mm_cvttps_epi32(fx));
+        _mm_storeu_si128((__m128i*)my, _mm_cvttps_epi32(fy));
+        _mm_storeu_si128((__m128i*)tx, _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(fx, mipSize)), mipMask));
+        _mm_storeu_si128((__m128i*)ty, _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(fy, mipSize)), mipMask));
+        for (int k = 0; k < 4; ++k) {
+            uint32_t px = fs->fallback;
+            if (insideBits & (1 << k)) {
+                int cell = my[k] * fs->mapW + mx[k];
+                int base = fs->textureTexels[fs->cellTextures[cell]];
+                if (base >= 0) {
+                    int index = fs->texels[base + row->mipOffset + ty[k] * row->mipSize + tx[k]];
+                    const uint32_t *colormap = (const uint32_t*)(fs->texels + base + fs->colormapDelta);
+                    px = colormap[levelOffset + index];
+                }
+            }
+            dst[i + k] = px;
+        }
+    }
+    floorRowScalar(dst, i, x1, row, fs);
+}
+
+// 8 pixels per iteration, fully vectorised with masked gathers
+__attribute__((target("avx2")))
+static void floorRowAVX2(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs) {
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256 posX = _mm256_set1_ps(row->posX), posY = _mm256_set1_ps(row->posY);
+    const __m256 stepX = _mm256_set1_ps(row->stepX), stepY = _mm256_set1_ps(row->stepY);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 mapW = _mm256_set1_ps((float)fs->mapW), mapH = _mm256_set1_ps((float)fs->mapH);
+    const __m256 mipSize = _mm256_set1_ps((float)row->mipSize);
+    const __m256i mapWi = _mm256_set1_epi32(fs->mapW);
+    const __m256i mipMask = _mm256_set1_epi32(row->mipSize - 1);
+    const __m256i mipRow = _mm256_set1_epi32(row->mipSize);
+    const __m256i mipOffset = _mm256_set1_epi32(row->mipOffset);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i idMask = _mm256_set1_epi32(0xFFFF);
+    const __m256i levelOffset = _mm256_set1_epi32(row->level * 256);
+    const __m256i fallback = _mm256_set1_epi32((int)fs->fallback);
+    int i = x0;
+    for (; i + 8 <= x1; i += 8) {
+        __m256 fi = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), lanes));
+        __m256 fx = _mm256_add_ps(_mm256_mul_ps(fi, stepX), posX);
+        __m256 fy = _mm256_add_ps(_mm256_mul_ps(fi, stepY), posY);
+        __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(fx, zero, _CMP_GE_OQ), _mm256_cmp_ps(fx, mapW, _CMP_LT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(fy, zero, _CMP_GE_OQ), _mm256_cmp_ps(fy, mapH, _CMP_LT_OQ)));
+        if (_mm256_movemask_ps(inside) == 0) {
+            _mm256_storeu_si256((__m256i*)(dst + i), fallback);
+            continue;
+        }
+        fx = _mm256_and_ps(fx, inside);
+        fy = _mm256_and_ps(fy, inside);
+        __m256i insideI = _mm256_castps_si256(inside);
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(fy), mapWi), _mm256_cvttps_epi32(fx));
+        // 16-bit texture ids: gather 32 bits and keep the low half
+        __m256i id = _mm256_and_si256(
+            _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)fs->cellTextures, cell, insideI, 2), idMask);
+        __m256i base = _mm256_mask_i32gather_epi32(_mm256_set1_epi32(-1), fs->textureTexels, id, insideI, 4);
+        __m256i valid = _mm256_andnot_si256(_mm256_srai_epi32(base, 31), insideI);
+        __m256i tx = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(fx, mipSize)), mipMask);
+        __m256i ty = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(fy, mipSize)), mipMask);
+        __m256i texelOffset = _mm256_add_epi32(_mm256_add_epi32(base, mipOffset),
+                                               _mm256_add_epi32(_mm256_mullo_epi32(ty, mipRow), tx));
+        // Byte-sized palette indices: gather 32 bits and keep the low byte
+        __m256i index = _mm256_and_si256(
+            _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)fs->texels, texelOffset, valid, 1), byteMask);
+        // The colormap sits a fixed distance after the texels, so the same
+        // per-cell offset addresses it (byte-scaled)
+        __m256i colorOffset = _mm256_add_epi32(base, _mm256_slli_epi32(_mm256_add_epi32(levelOffset, index), 2));
+        __m256i px = _mm256_mask_i32gather_epi32(fallback, (const int*)(fs->texels + fs->colormapDelta), colorOffset, valid, 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), px);
+    }
+    floorRowScalar(dst, i, x1, row, fs);
+}
+#endif
+
+static FloorRowFn floorRowFn = floorRowScalar;
+static const char *pathName = "scalar";
+
+static int selectSpanKernels(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        floorRowFn = floorRowScalar;
+        pathName = "scalar";
+        return 1;
+    }
+#ifdef RASTER_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        floorRowFn = floorRowSSE2;
+        pathName = "sse2";
+        return 1;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        floorRowFn = floorRowAVX2;
+        pathName = "avx2";
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+// Force a specific kernel set ("scalar", "sse2", "avx2"); 0 if unsupported
+// here. The batch ray caster (raycast.c) follows a forced choice.
+int rasterSelect(const char *name) {
+    if (!selectSpanKernels(name)) return 0;
+    rayCastSelect(name);
+    return 1;
+}
+
+// Pick the widest span kernels the CPU supports. Rays keep the scalar
+// march: the AVX2 lockstep caster measures from 0.5x to 1.3x of it on the
+// shipped maps (raybench), slower on some, so it only runs when asked for.
+void rasterInit(void) {
+    if (!rasterSelect("avx2") && !rasterSelect("sse2")) rasterSelect("scalar");
+    rayCastSelect("scalar");
+}
+
+const char *rasterPathName(void) {
+    return pathName;
+}
+
+void rasterFloorRow(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs) {
+    if (x0 < x1) floorRowFn(dst, x0, x1, row, fs);
+}
+
+void rasterWallColumn(uint32_t *dst, int stride, int count, const WallSpan *ws) {
+    const uint8_t *column = ws->column;
+    const uint32_t *colormap = ws->colormap;
+    const int texelStride = ws->texelStride;
+    const int maskY = ws->texMaskY;
+    uint32_t texY = ws->texY;
+    const uint32_t step = ws->texStep;
+    for (int i = 0; i < count; ++i) {
+        *dst = colormap[column[(int)(texY >> 16 & maskY) * texelStride]];
+        dst += stride;
+        texY += step;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "raywhen.h"
+
+// One floor row. The world position is stepped linearly across the row
+// (camera-plane projection), so no trig is needed per pixel; the light
+// level and mip level are resolved once for the whole row.
+typedef struct {
+    float posX, posY;   // floor position under the row's first pixel
+    float stepX, stepY; // floor position increment per pixel
+    int level;          // light level (colormap row)
+    int mipOffset;      // start of the row's mip level within a texture's texels
+    int mipSize;        // width/height of that mip level (power of two)
+} FloorRow;
+
+// Per-frame lookup state shared by all floor rows
+typedef struct {
+    const uint8_t *texels;         // base for textureTexels offsets (palette indices)
+    const uint16_t *cellTextures;  // per map cell: floor texture id (readable one element past the end)
+    const int *textureTexels;      // per texture id: byte offset of its texels (level 0), or -1
+    int colormapDelta;             // bytes from a texture's texels to its colormap (4-aligned)
+    int mapW, mapH;
+    uint32_t fallback;             // BGRA for untextured cells and outside the map
+} FloorSampler;
+
+// One textured wall column, already clipped to the screen. Texture rows
+// are stepped in 16.16 fixed point; light level and mip are per column.
+// Walls sample the column-major texture copies (texelStride 1), so a
+// column's texels are contiguous.
+typedef struct {
+    const uint8_t *column;    // first texel (palette index) of the column in the chosen mip
+    const uint32_t *colormap; // BGRA palette for the column's light level
+    int texelStride;          // texels between vertically adjacent samples
+    int texMaskY;             // mip height - 1
+    uint32_t texY;            // 16.16 texture row of the first pixel
+    uint32_t texStep;         // 16.16 texture rows per screen pixel
+} WallSpan;
+
+// Function declarations
+void rasterInit(void);
+int rasterSelect(const char *name);
+const char *rasterPathName(void);
+void rasterFloorRow(uint32_t *dst, int x0, int x1, const FloorRow *row, const FloorSampler *fs);
+void rasterWallColumn(uint32_t *dst, int stride, int count, const WallSpan *ws);
+
+#endif // RASTER_H
@@ -0,0 +1,291 @@
+// Raycast benchmark: casts full camera-plane ray sets from a spread of
+// open cells in each map and reports ns per ray for single castRayFrom()
+// calls (in double, float and fixed point) and for castRays() with each
+// kernel set the CPU supports. The batch results are also checked against
+// the single-ray ones. Last, each position turns in place for a few frames
+// with and without the ray cache.
+#include "raywhen.h"
+#include "map.h"
+#include "raycast.h"
+#include "raster.h"
+#include "raycache.h"
+#include "profiler.h"
+
+// Global screen dimensions (unused, but the engine core expects them)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+#define BENCH_POSITIONS 8
+#define BENCH_ANGLES 8
+#define YAW_FRAMES 16
+#define YAW_STEP 0.005 // radians per frame, a slow mouse pan
+#define MAX_BENCH_MAPS 16
+
+typedef struct {
+    double *distance, *wallX;
+    int *wallType, *side, *textureId, *mapX, *mapY;
+    RayHits hits;
+} HitBuffer;
+
+static int allocHits(HitBuffer *b, int count) {
+    b->distance = (double*)malloc(sizeof(double) * count);
+    b->wallX = (double*)malloc(sizeof(double) * count);
+    b->wallType = (int*)malloc(sizeof(int) * count);
+    b->side = (int*)malloc(sizeof(int) * count);
+    b->textureId = (int*)malloc(sizeof(int) * count);
+    b->mapX = (int*)malloc(sizeof(int) * count);
+    b->mapY = (int*)malloc(sizeof(int) * count);
+    RayHits hits = { b->distance, b->wallX, b->wallType, b->side, b->textureId, b->mapX, b->mapY };
+    b->hits = hits;
+    return b->distance && b->wallX && b->wallType && b->side && b->textureId && b->mapX && b->mapY;
+}
+
+static void freeHits(HitBuffer *b) {
+    free(b->distance); free(b->wallX); free(b->wallType); free(b->side);
+    free(b->textureId); free(b->mapX); free(b->mapY);
+}
+
+// Rays that differ in any field (bitwise for the doubles)
+static int countMismatches(const HitBuffer *a, const HitBuffer *b, int count) {
+    int bad = 0;
+    for (int i = 0; i < count; ++i) {
+        if (memcmp(&a->distance[i], &b->distance[i], sizeof(double)) != 0 ||
+            memcmp(&a->wallX[i], &b->wallX[i], sizeof(double)) != 0 ||
+            a->wallType[i] != b->wallType[i] || a->side[i] != b->side[i] ||
+            a->textureId[i] != b->textureId[i] || a->mapX[i] != b->mapX[i] || a->mapY[i] != b->mapY[i]) {
+            bad++;
+        }
+    }
+    return bad;
+}
+
+// Up to BENCH_POSITIONS open cell centers spread over the map
+static int pickPositions(double *posX, double *posY) {
+    int count = 0;
+    for (int k = 0; k < BENCH_POSITIONS * 4 && count < BENCH_POSITIONS; ++k) {
+        // Scan from a point on the diagonal-ish lattice for the next open cell
+        int start = (int)(((long long)map.width * map.height * (2 * k + 1)) / (BENCH_POSITIONS * 8));
+        for (int c = 0; c < map.width * map.height; ++c) {
+            int cell = (start + c) % (map.width * map.height);
+            int x = cell % map.width, y = cell / map.width;
+            if (mapWall(x, y) != 0) continue;
+            int seen = 0;
+            for (int i = 0; i < count; ++i) seen |= (int)posX[i] == x && (int)posY[i] == y;
+            if (seen) break;
+            posX[count] = x + 0.37;
+            posY[count] = y + 0.61;
+            count++;
+            break;
+        }
+    }
+    return count;
+}
+
+static void benchMap(const char *path, int width, int passes) {
+    if (path && !loadMapFromFile(path)) {
+        printf("%s: failed to load\n", path);
+        return;
+    }
+    double posX[BENCH_POSITIONS], posY[BENCH_POSITIONS];
+    int positions = pickPositions(posX, posY);
+    if (positions == 0) {
+        printf("%s: no open cells\n", path ? path : "built-in map");
+        return;
+    }
+
+    // Every view's camera-plane directions, laid out back to back
+    int views = positions * BENCH_ANGLES;
+    int rays = views * width;
+    double *dirX = (double*)malloc(sizeof(double) * rays);
+    double *dirY = (double*)malloc(sizeof(double) * rays);
+    HitBuffer reference, batch;
+    if (!dirX || !dirY || !allocHits(&reference, rays) || !allocHits(&batch, rays)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    double planeScale = tan(FOV / 2.0);
+    for (int v = 0; v < views; ++v) {
+        double angle = (v % BENCH_ANGLES) * (2.0 * M_PI / BENCH_ANGLES) + 0.1;
+        double forwardX = cos(angle), forwardY = sin(angle);
+        for (int x = 0; x < width; ++x) {
+            double camera = (2.0 * x / width - 1.0) * planeScale;
+            dirX[v * width + x] = forwardX - forwardY * camera;
+            dirY[v * width + x] = forwardY + forwardX * camera;
+        }
+    }
+
+    printf("%s: %dx%d, %d views of %d rays\n", path ? path : "built-in map", map.width, map.height, views, width);
+
+    // Single rays, stored the way the batch kernels store them
+    double best = 1e30;
+    for (int p = 0; p <= passes; ++p) {
+        double t0 = profilerNow();
+        for (int v = 0; v < views; ++v) {
+            int first = v * width;
+            for (int i = first; i < first + width; ++i) {
+                RayResult r = castRayFrom(posX[v / BENCH_ANGLES], posY[v / BENCH_ANGLES], dirX[i], dirY[i]);
+                reference.distance[i] = r.distance;
+                reference.wallX[i] = r.wallX;
+                reference.wallType[i] = r.wallType;
+                reference.side[i] = r.side;
+                reference.textureId[i] = r.mapX >= 0 ? map.textures[(size_t)r.mapY * map.width + r.mapX] : 0;
+                reference.mapX[i] = r.mapX;
+                reference.mapY[i] = r.mapY;
+            }
+        }
+        double t = profilerNow() - t0;
+        if (p > 0 && t < best) best = t; // pass 0 warms up
+    }
+    double scalarNs = best * 1e6 / rays;
+    printf("  %-18s %8.1f ns/ray\n", "castRayFrom", scalarNs);
+
+    // Reduced-precision marches, single rays (accuracy: raycheck)
+    static const char *const precisions[] = { "float", "fixed" };
+    for (int k = 0; k < 2; ++k) {
+        rayCastPrecisionSelect(precisions[k]);
+        best = 1e30;
+        for (int p = 0; p <= passes; ++p) {
+            double t0 = profilerNow();
+            for (int v = 0; v < views; ++v) {
+                for (int i = v * width; i < (v + 1) * width; ++i) {
+                    RayResult r = castRayFrom(posX[v / BENCH_ANGLES], posY[v / BENCH_ANGLES], dirX[i], dirY[i]);
+                    batch.distance[i] = r.distance;
+                }
+            }
+            double t = profilerNow() - t0;
+            if (p > 0 && t < best) best = t;
+        }
+        double ns = best * 1e6 / rays;
+        char name[32];
+        snprintf(name, sizeof(name), "castRayFrom %s", precisions[k]);
+        printf("  %-18s %8.1f ns/ray  %5.2fx\n", name, ns, scalarNs / ns);
+    }
+    rayCastPrecisionSelect("double");
+
+    static const char *const kernels[] = { "scalar", "sse2", "avx2" };
+    for (int k = 0; k < 3; ++k) {
+        if (!rasterSelect(kernels[k])) continue;
+        best = 1e30;
+        for (int p = 0; p <= passes; ++p) {
+            double t0 = profilerNow();
+            for (int v = 0; v < views; ++v) {
+                const RayHits *h = &batch.hits;
+                RayHits slice = { h->distance + v * width, h->wallX + v * width, h->wallType + v * width,
+                                  h->side + v * width, h->textureId + v * width, h->mapX + v * width,
+                                  h->mapY + v * width };
+                castRays(posX[v / BENCH_ANGLES], posY[v / BENCH_ANGLES], dirX + v * width, dirY + v * width,
+                         width, &slice);
+            }
+            double t = profilerNow() - t0;
+            if (p > 0 && t < best) best = t;
+        }
+        double ns = best * 1e6 / rays;
+        char name[32];
+        snprintf(name, sizeof(name), "castRays %s", kernels[k]);
+        printf("  %-18s %8.1f ns/ray  %5.2fx  %d mismatches\n", name, ns, scalarNs / ns,
+               countMismatches(&reference, &batch, rays));
+    }
+    rasterInit();
+
+    // Turning in place: the same frames cast directly and through the ray
+    // cache, which starts empty at every position
+    int yawRays = YAW_FRAMES * width;
+    double *yawX = (double*)malloc(sizeof(double) * yawRays);
+    double *yawY = (double*)malloc(sizeof(double) * yawRays);
+    double *yawAngle = (double*)malloc(sizeof(double) * yawRays);
+    HitBuffer direct, cached;
+    if (!yawX || !yawY || !yawAngle || !allocHits(&direct, yawRays) || !allocHits(&cached, yawRays)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (int f = 0; f < YAW_FRAMES; ++f) {
+        double angle = 0.1 + f * YAW_STEP;
+        double forwardX = cos(angle), forwardY = sin(angle);
+        for (int x = 0; x < width; ++x) {
+            double camera = (2.0 * x / width - 1.0) * planeScale;
+            yawX[f * width + x] = forwardX - forwardY * camera;
+            yawY[f * width + x] = forwardY + forwardX * camera;
+            yawAngle[f * width + x] = angle + atan(camera);
+        }
+    }
+    double yawNs[2];
+    RayCacheStats before, after;
+    rayCacheGetStats(&before);
+    rayCacheEnabled = 1;
+    for (int c = 0; c < 2; ++c) {
+        HitBuffer *out = c ? &cached : &direct;
+        best = 1e30;
+        for (int p = 0; p <= passes; ++p) {
+            double t0 = profilerNow();
+            for (int pos = 0; pos < positions; ++pos) {
+                if (c) rayCacheInvalidate();
+                for (int f = 0; f < YAW_FRAMES; ++f) {
+                    if (c) rayCacheBeginFrame(posX[pos], posY[pos]);
+                    const RayHits *h = &out->hits;
+                    int o = f * width;
+                    RayHits slice = { h->distance + o, h->wallX + o, h->wallType + o, h->side + o,
+                                      h->textureId + o, h->mapX + o, h->mapY + o };
+                    if (c) {
+                        castRaysCached(posX[pos], posY[pos], yawX + o, yawY + o, yawAngle + o, width, &slice);
+                    } else {
+                        castRays(posX[pos], posY[pos], yawX + o, yawY + o, width, &slice);
+                    }
+                }
+            }
+            double t = profilerNow() - t0;
+            if (p > 0 && t < best) best = t;
+        }
+        yawNs[c] = best * 1e6 / ((double)positions * yawRays);
+    }
+    // Reused faces should give the cast results bit for bit (last position)
+    int yawMismatches = countMismatches(&direct, &cached, yawRays);
+    rayCacheGetStats(&after);
+    long long hits = after.hits - before.hits, misses = after.misses - before.misses;
+    printf("  %-18s %8.1f ns/ray\n", "castRays yaw", yawNs[0]);
+    printf("  %-18s %8.1f ns/ray  %5.2fx  %d mismatches, %.1f%% hits\n", "castRaysCached yaw",
+           yawNs[1], yawNs[0] / yawNs[1], yawMismatches, 100.0 * hits / (hits + misses));
+
+    free(yawX);
+    free(yawY);
+    free(yawAngle);
+    freeHits(&direct);
+    freeHits(&cached);
+    free(dirX);
+    free(dirY);
+    freeHits(&reference);
+    freeHits(&batch);
+}
+
+int main(int argc, char **argv) {
+    const char *maps[MAX_BENCH_MAPS];
+    int mapCount = 0;
+    int width = 3840;
+    int passes = 5;
+    for (int i = 1; i < argc; ++i) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-map") == 0 && next) {
+            if (mapCount < MAX_BENCH_MAPS) maps[mapCount++] = next;
+            i++;
+        } else if (strcmp(argv[i], "-w") == 0 && next) {
+            width = atoi(next); i++;
+            if (width < 1) width = 1;
+        } else if (strcmp(argv[i], "-passes") == 0 && next) {
+            passes = atoi(next); i++;
+            if (passes < 1) passes = 1;
+        } else {
+            printf("Usage: %s [-map file.rwm]... [-w width] [-passes n]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (mapCount == 0) {
+        maps[mapCount++] = "maps/map.rwm";
+        maps[mapCount++] = "maps/arena.rwm";
+        maps[mapCount++] = "maps/littlehouse.rwm";
+    }
+
+    rasterInit();
+    rayCastPrecisionSelect("double");
+    printf("%d passes per path (time from the fastest), widest kernels: %s\n", passes, rasterPathName());
+    for (int m = 0; m < mapCount; ++m) benchMap(maps[m], width, passes);
+    return 0;
+}
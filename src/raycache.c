@@ -0,0 +1,279 @@
+// Angular ray-result cache (see raycache.h)
+#include "raycache.h"
+#include "map.h"
+
+// Rays looked up per castRays() call on the misses
+#define RAY_CACHE_BATCH 64
+// Longest grid-line scan when filling an entry. Rays that cross more lines
+// of both axes pass so close to some corner that hardly any other ray
+// could reuse them, so they are not cached.
+#define RAY_CACHE_MAX_SCAN 64
+// Generation of an entry while one thread writes it
+#define RAY_CACHE_BUSY 0xFFFFFFFFu
+
+// The face a ray hit: side 0 faces lie on x = mapX or mapX + 1, side 1
+// faces on y = mapY or mapY + 1, whichever is nearer the origin; mapX < 0
+// for a ray that left the map. Rays from the origin pass through the same
+// cells as the cached one as long as no grid corner lies between them, so
+// the entry also keeps how far the slope (across / along the scan axis)
+// may move before one does.
+typedef struct {
+    uint32_t generation; // cache generation it was filled in (0 = never)
+    int side;
+    int wallType, textureId, mapX, mapY;
+    int exitSide, exitLine, exitCell; // left the map across x (0) or y (1) = exitLine, in that cell
+    int axis;            // scan axis: 0 = x, 1 = y
+    int step;            // direction along it, -1 or 1
+    double slopeLow, slopeHigh; // open range of slopes (across / along) that keep its cells
+} RayCacheEntry;
+
+int rayCacheEnabled = 0;
+
+static RayCacheEntry entries[RAY_CACHE_BINS];
+// Entries of any other generation are empty. Only changed between frames.
+static uint32_t generation = 1;
+static int originKnown = 0;
+static double cacheX, cacheY;
+static unsigned int cacheMapRevision;
+// Set once a frame starts where the last one did: the first frame at a
+// new origin casts without filling, so walking pays nothing for the cache
+static int filling = 0;
+static RayCacheStats stats;
+
+// floor() without the library call, for values well inside long long
+static inline long long floorToInt(double v) {
+    long long i = (long long)v;
+    return i - (v < (double)i);
+}
+
+// Nearest bin; the heading is unbounded but stays far inside long long
+static inline int binOf(double angle) {
+    return (int)(floorToInt(angle * (RAY_CACHE_BINS / (2.0 * M_PI)) + 0.5) & (RAY_CACHE_BINS - 1));
+}
+
+// Empty every entry; not while a frame renders
+void rayCacheInvalidate(void) {
+    if (++generation == RAY_CACHE_BUSY) {
+        memset(entries, 0, sizeof(entries));
+        generation = 1;
+    }
+    originKnown = 0;
+    filling = 0;
+    stats.flushes++;
+}
+
+void rayCacheBeginFrame(double originX, double originY) {
+    if (!rayCacheEnabled) return;
+    if (originKnown && originX == cacheX && originY == cacheY && mapRevision == cacheMapRevision) {
+        filling = 1;
+        return;
+    }
+    rayCacheInvalidate();
+    cacheX = originX;
+    cacheY = originY;
+    cacheMapRevision = mapRevision;
+    originKnown = 1;
+}
+
+// Slope range of a hit ray within which no grid corner lies between it
+// and the ray, up to the hit. Every corner has integer coordinates on both
+// axes, so it is enough to scan the grid lines of the axis the ray crosses
+// fewest of; 0 if the ray runs along a grid line or crosses too many.
+static int corridor(RayCacheEntry *e, double originX, double originY, double dirX, double dirY,
+                    double distance) {
+    if (dirX == 0.0 || dirY == 0.0 || !(distance > 0.0)) return 0;
+    double hitX = originX + distance * dirX, hitY = originY + distance * dirY;
+    int axis = fabs(hitX - originX) <= fabs(hitY - originY) ? 0 : 1;
+    double from = axis ? originY : originX, to = axis ? hitY : hitX;
+    if (fabs(to - from) > RAY_CACHE_MAX_SCAN) return 0;
+    double across = axis ? originX : originY;
+    double slope = axis ? dirX / dirY : dirY / dirX;
+    double low = 1e30, high = 1e30;
+    int step = (axis ? dirY : dirX) > 0 ? 1 : -1;
+    int line = step > 0 ? (int)floor(from) + 1 : (int)ceil(from) - 1;
+    for (; step > 0 ? line < to : line > to; line += step) {
+        double t = line - from;
+        double c = across + t * slope;
+        // Distances to the corners either side, less a little for rounding
+        double below = c - floor(c) - 1e-9, above = 1.0 - (c - floor(c)) - 1e-9;
+        if (below < 0.0) below = 0.0;
+        if (above < 0.0) above = 0.0;
+        // Raising the slope moves the crossing by t per unit
+        double up = (t > 0 ? above : below) / fabs(t);
+        double down = (t > 0 ? below : above) / fabs(t);
+        if (up < high) high = up;
+        if (down < low) low = down;
+    }
+    e->axis = axis;
+    e->step = step;
+    e->slopeLow = slope - low;
+    e->slopeHigh = slope + high;
+    return 1;
+}
+
+// Intersect a ray with a cached face as finishRay() in raycast.c does;
+// 0 if a grid corner may lie between the two rays, or the ray meets the
+// face line outside the cell or from behind
+static int reuseFace(const RayCacheEntry *e, double originX, double originY, double dirX, double dirY,
+                     const RayHits *hits, int i) {
+    // Slope range test multiplied through by the along component, whose
+    // sign must match the cached ray's
+    double along = e->axis ? dirY : dirX, across = e->axis ? dirX : dirY;
+    if (e->step > 0) {
+        if (!(along > 0) || !(across > e->slopeLow * along && across < e->slopeHigh * along)) return 0;
+    } else {
+        if (!(along < 0) || !(across < e->slopeLow * along && across > e->slopeHigh * along)) return 0;
+    }
+    if (e->mapX < 0) {
+        // Out of the map through the same edge cell, so through the same
+        // empty cells all the way (see finishRay() for the result)
+        double exit = e->exitSide == 0 ? (e->exitLine - originX) / dirX : (e->exitLine - originY) / dirY;
+        if (!(exit > 0.0)) return 0;
+        double edge = e->exitSide == 0 ? originY + exit * dirY : originX + exit * dirX;
+        if (floorToInt(edge) != e->exitCell) return 0;
+        hits->distance[i] = MAX_DISTANCE;
+        hits->wallX[i] = 0.0;
+        hits->wallType[i] = e->wallType;
+        hits->side[i] = e->side;
+        hits->textureId[i] = e->textureId;
+        hits->mapX[i] = hits->mapY[i] = -1;
+        return 1;
+    }
+    double distance, wallX;
+    long long cell;
+    if (e->side == 0) {
+        int stepX = e->mapX > originX ? 1 : -1;
+        if (stepX > 0 ? !(dirX > 0) : !(dirX < 0)) return 0;
+        distance = (e->mapX - originX + (1 - stepX) / 2) / dirX;
+        wallX = originY + distance * dirY;
+        cell = floorToInt(wallX);
+        if (cell != e->mapY) return 0;
+    } else {
+        int stepY = e->mapY > originY ? 1 : -1;
+        if (stepY > 0 ? !(dirY > 0) : !(dirY < 0)) return 0;
+        distance = (e->mapY - originY + (1 - stepY) / 2) / dirY;
+        wallX = originX + distance * dirX;
+        cell = floorToInt(wallX);
+        if (cell != e->mapX) return 0;
+    }
+    hits->distance[i] = distance;
+    hits->wallX[i] = wallX - (double)cell;
+    hits->wallType[i] = e->wallType;
+    hits->side[i] = e->side;
+    hits->textureId[i] = e->textureId;
+    hits->mapX[i] = e->mapX;
+    hits->mapY[i] = e->mapY;
+    return 1;
+}
+
+// Fill an entry unless it is current or another thread is writing it
+static void storeEntry(RayCacheEntry *e, double originX, double originY, double dirX, double dirY,
+                       const RayHits *hits, int i) {
+    // corridor() turns these down too, but a ray along a grid line has no
+    // exit on the other axis to work out first
+    if (dirX == 0.0 || dirY == 0.0) return;
+    uint32_t seen = __atomic_load_n(&e->generation, __ATOMIC_RELAXED);
+    if (seen == generation || seen == RAY_CACHE_BUSY) return;
+    if (!__atomic_compare_exchange_n(&e->generation, &seen, RAY_CACHE_BUSY, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+    double distance = hits->distance[i];
+    if (hits->mapX[i] < 0) {
+        // Out to where the ray leaves the map
+        int lineX = dirX > 0 ? map.width : 0, lineY = dirY > 0 ? map.height : 0;
+        double exitX = (lineX - originX) / dirX, exitY = (lineY - originY) / dirY;
+        e->exitSide = exitX < exitY ? 0 : 1;
+        e->exitLine = e->exitSide == 0 ? lineX : lineY;
+        distance = e->exitSide == 0 ? exitX : exitY;
+        e->exitCell = (int)floorToInt(e->exitSide == 0 ? originY + distance * dirY : originX + distance * dirX);
+    }
+    if (!corridor(e, originX, originY, dirX, dirY, distance)) {
+        // Leave it empty
+        __atomic_store_n(&e->generation, seen, __ATOMIC_RELEASE);
+        return;
+    }
+    e->wallType = hits->wallType[i];
+    e->side = hits->side[i];
+    e->textureId = hits->textureId[i];
+    e->mapX = hits->mapX[i];
+    e->mapY = hits->mapY[i];
+    __atomic_store_n(&e->generation, generation, __ATOMIC_RELEASE);
+}
+
+// castRays() for rays from the origin given to rayCacheBeginFrame(), with
+// angle[i] the world angle of direction i. Distances come back in lengths
+// of each ray's own direction, as from castRays().
+void castRaysCached(double originX, double originY, const double *dirX, const double *dirY,
+                    const double *angle, int count, const RayHits *hits) {
+    if (!rayCacheEnabled || rayCastPrecision() != RAY_PRECISION_DOUBLE) {
+        castRays(originX, originY, dirX, dirY, count, hits);
+        return;
+    }
+    double missX[RAY_CACHE_BATCH], missY[RAY_CACHE_BATCH];
+    int missIndex[RAY_CACHE_BATCH], missBin[RAY_CACHE_BATCH];
+    double distance[RAY_CACHE_BATCH], wallX[RAY_CACHE_BATCH];
+    int wallType[RAY_CACHE_BATCH], side[RAY_CACHE_BATCH], textureId[RAY_CACHE_BATCH];
+    int mapX[RAY_CACHE_BATCH], mapY[RAY_CACHE_BATCH];
+    const RayHits missHits = { distance, wallX, wallType, side, textureId, mapX, mapY };
+    long long hitCount = 0, missCount = 0;
+
+    for (int first = 0; first < count; first += RAY_CACHE_BATCH) {
+        int end = first + RAY_CACHE_BATCH < count ? first + RAY_CACHE_BATCH : count;
+        int misses = 0;
+        for (int i = first; i < end; ++i) {
+            int bin = binOf(angle[i]);
+            const RayCacheEntry *e = &entries[bin];
+            if (__atomic_load_n(&e->generation, __ATOMIC_ACQUIRE) == generation &&
+                reuseFace(e, originX, originY, dirX[i], dirY[i], hits, i)) {
+                continue;
+            }
+            missX[misses] = dirX[i];
+            missY[misses] = dirY[i];
+            missBin[misses] = bin;
+            missIndex[misses++] = i;
+        }
+        hitCount += (end - first) - misses;
+        missCount += misses;
+        if (misses == 0) continue;
+
+        castRays(originX, originY, missX, missY, misses, &missHits);
+        for (int m = 0; m < misses; ++m) {
+            int i = missIndex[m];
+            hits->distance[i] = distance[m];
+            hits->wallX[i] = wallX[m];
+            hits->wallType[i] = wallType[m];
+            hits->side[i] = side[m];
+            hits->textureId[i] = textureId[m];
+            hits->mapX[i] = mapX[m];
+            hits->mapY[i] = mapY[m];
+            if (filling) {
+                storeEntry(&entries[missBin[m]], originX, originY, missX[m], missY[m], &missHits, m);
+            }
+        }
+    }
+    __atomic_fetch_add(&stats.hits, hitCount, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats.misses, missCount, __ATOMIC_RELAXED);
+}
+
+void rayCacheGetStats(RayCacheStats *out) {
+    out->hits = __atomic_load_n(&stats.hits, __ATOMIC_RELAXED);
+    out->misses = __atomic_load_n(&stats.misses, __ATOMIC_RELAXED);
+    out->flushes = stats.flushes;
+}
+
+int rayCacheFormat(char *buf, size_t size) {
+    RayCacheStats s;
+    rayCacheGetStats(&s);
+    long long rays = s.hits + s.misses;
+    int len;
+    if (!rayCacheEnabled) {
+        len = snprintf(buf, size, "Ray cache: off");
+    } else {
+        len = snprintf(buf, size, "Ray cache: hits %lld (%.1f%%), misses %lld, flushes %lld",
+                       s.hits, rays ? 100.0 * s.hits / rays : 0.0, s.misses, s.flushes);
+    }
+    if (len < 0) len = 0;
+    if ((size_t)len >= size) len = size > 0 ? (int)size - 1 : 0;
+    return len;
+}
@@ -0,0 +1,42 @@
+#ifndef RAYCACHE_H
+#define RAYCACHE_H
+
+#include "raywhen.h"
+#include "raycast.h"
+
+// Ray results by world angle, for frames where the view only turns. The
+// full turn is split into RAY_CACHE_BINS bins, each holding the wall face
+// hit by the last ray cast through it from the current origin (or the
+// fact that it left the map), together with the range of slopes around
+// that ray that cross no grid corner before the hit. A ray that lands in
+// a filled bin within that range passes through the same cells, so it is
+// intersected with the cached face the way the double march finishes,
+// and the result matches castRays() bit for bit; any other ray is cast.
+// Only the double march is cached. rayCacheBeginFrame() empties the cache
+// when the origin or the map changes, and the cache only fills from the
+// second frame at one origin, so frames that move pay little for it.
+// It is off unless asked for (-ray-cache): on the maps measured so far
+// the lookups cost more than the marches they save.
+//
+// Lookups and fills may run on any render thread. An entry is claimed
+// with a compare-and-swap on its generation, filled, then published with a
+// release store; readers acquire the generation before the payload.
+#define RAY_CACHE_BINS 65536
+
+typedef struct {
+    long long hits;    // rays answered from the cache
+    long long misses;  // rays cast, including ones whose cached face did not fit
+    long long flushes; // origin or map changes
+} RayCacheStats;
+
+extern int rayCacheEnabled; // 1 = reuse rays while the view only turns (-ray-cache)
+
+// Function declarations
+void rayCacheBeginFrame(double originX, double originY);
+void rayCacheInvalidate(void);
+void castRaysCached(double originX, double originY, const double *dirX, const double *dirY,
+                    const double *angle, int count, const RayHits *hits);
+void rayCacheGetStats(RayCacheStats *stats);
+int rayCacheFormat(char *buf, size_t size);
+
+#endif // RAYCACHE_H
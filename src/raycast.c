@@ -0,0 +1,692 @@
+// Grid raycasting: a DDA over the map's occupancy levels (see map.h) that
+// leaps across empty 8x8 and 64x64 blocks, for single rays and batches.
+//
+// castRays() follows the kernel set picked for raster.c by rasterInit()/
+// rasterSelect(). The AVX2 kernel marches 4 rays in double-precision lanes
+// until every lane has hit or left the map; each lane makes the same leaps
+// and steps as the scalar march with the same arithmetic, so both paths
+// return bit-identical results. There is no SSE2 kernel: with 2 lanes and
+// no gathers the lookups go back to scalar code and it ran at half the
+// speed of the scalar march, so "sse2" uses the scalar loop.
+#include "raycast.h"
+#include "map.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAYCAST_X86 1
+#include <immintrin.h>
+#endif
+
+// DDA state: the current cell, and the ray distance at which it next
+// crosses a vertical (sideDistX) or horizontal (sideDistY) grid line
+typedef struct {
+    int mapX, mapY;
+    int stepX, stepY;
+    double sideDistX, sideDistY;
+    double deltaDistX, deltaDistY;
+    double absDirX, absDirY;     // 1 / deltaDist, for counting crossings
+    int side;
+} RayMarch;
+
+static inline void startMarch(RayMarch *r, double originX, double originY, double dirX, double dirY) {
+    // Axis-parallel rays never cross the other axis' grid lines
+    r->deltaDistX = (dirX == 0.0) ? 1e30 : fabs(1.0 / dirX);
+    r->deltaDistY = (dirY == 0.0) ? 1e30 : fabs(1.0 / dirY);
+    r->absDirX = fabs(dirX);
+    r->absDirY = fabs(dirY);
+
+    r->mapX = (int)originX;
+    r->mapY = (int)originY;
+    r->side = 0;
+
+    if (dirX < 0) {
+        r->stepX = -1;
+        r->sideDistX = (originX - r->mapX) * r->deltaDistX;
+    } else {
+        r->stepX = 1;
+        r->sideDistX = (r->mapX + 1.0 - originX) * r->deltaDistX;
+    }
+
+    if (dirY < 0) {
+        r->stepY = -1;
+        r->sideDistY = (originY - r->mapY) * r->deltaDistY;
+    } else {
+        r->stepY = 1;
+        r->sideDistY = (r->mapY + 1.0 - originY) * r->deltaDistY;
+    }
+}
+
+// Move the march to the first cell past the empty (1 << shift)-cell block
+// it is in. The grid lines crossed inside the block are counted rather
+// than stepped, keeping the cell loop's tie rule (y first on equal
+// distances), so the march leaves the block through the same cell.
+static inline void leapBlock(RayMarch *r, int shift) {
+    int size = 1 << shift;
+    int blockX = r->mapX & ~(size - 1), blockY = r->mapY & ~(size - 1);
+    // Grid lines still inside the block on each axis; the next one leaves it
+    int insideX = r->stepX > 0 ? blockX + size - 1 - r->mapX : r->mapX - blockX;
+    int insideY = r->stepY > 0 ? blockY + size - 1 - r->mapY : r->mapY - blockY;
+    double exitX = r->sideDistX + insideX * r->deltaDistX;
+    double exitY = r->sideDistY + insideY * r->deltaDistY;
+    if (exitX < exitY) {
+        int crossY = exitX >= r->sideDistY ? (int)((exitX - r->sideDistY) * r->absDirY) + 1 : 0;
+        if (crossY > insideY) crossY = insideY;
+        r->mapY += crossY * r->stepY;
+        r->sideDistY += crossY * r->deltaDistY;
+        r->mapX += (insideX + 1) * r->stepX;
+        r->sideDistX = exitX + r->deltaDistX;
+        r->side = 0;
+    } else {
+        int crossX = 0;
+        if (exitY > r->sideDistX) {
+            double lines = (exitY - r->sideDistX) * r->absDirX;
+            crossX = (int)lines;
+            if (crossX < lines) crossX++;
+        }
+        if (crossX > insideX) crossX = insideX;
+        r->mapX += crossX * r->stepX;
+        r->sideDistX += crossX * r->deltaDistX;
+        r->mapY += (insideY + 1) * r->stepY;
+        r->sideDistY = exitY + r->deltaDistY;
+        r->side = 1;
+    }
+}
+
+// Distance and wall position for a finished march
+static inline RayResult finishRay(int hit, int mapX, int mapY, int side, double originX, double originY,
+                                  double dirX, double dirY) {
+    RayResult result;
+    if (hit) {
+        int stepX = dirX < 0 ? -1 : 1, stepY = dirY < 0 ? -1 : 1;
+        if (side == 0) {
+            result.distance = (mapX - originX + (1 - stepX) / 2) / dirX;
+            result.wallX = originY + result.distance * dirY;
+        } else {
+            result.distance = (mapY - originY + (1 - stepY) / 2) / dirY;
+            result.wallX = originX + result.distance * dirX;
+        }
+
+        result.wallX -= floor(result.wallX); // Keep only fractional part
+
+        result.wallType = mapWall(mapX, mapY);
+        result.side = side;
+        result.mapX = mapX;
+        result.mapY = mapY;
+    } else {
+        result.distance = MAX_DISTANCE;
+        result.wallType = 1;
+        result.side = 0;
+        result.wallX = 0.0;
+        result.mapX = -1;
+        result.mapY = -1;
+    }
+    return result;
+}
+
+static inline void storeHit(const RayHits *hits, int i, RayResult r) {
+    hits->distance[i] = r.distance;
+    hits->wallX[i] = r.wallX;
+    hits->wallType[i] = r.wallType;
+    hits->side[i] = r.side;
+    hits->textureId[i] = r.mapX >= 0 ? map.textures[(size_t)r.mapY * map.width + r.mapX] : 0;
+    hits->mapX[i] = r.mapX;
+    hits->mapY[i] = r.mapY;
+}
+
+// The reference march, in double
+static RayResult castRayDouble(double originX, double originY, double dirX, double dirY) {
+    RayMarch r;
+    startMarch(&r, originX, originY, dirX, dirY);
+
+    // DDA algorithm over the occupancy levels: leap across empty 64x64
+    // and 8x8 blocks, step cell by cell only inside occupied ones
+    const uint64_t *occupancy = map.occupancy;
+    const uint8_t *blocks = map.blocks, *superblocks = map.superblocks;
+    const int mapW = map.width, mapH = map.height;
+    const int stride = map.occupancyStride, blocksW = map.blocksWidth, superblocksW = map.superblocksWidth;
+    // The start cell is the only one that can be outside the map
+    int inside = (unsigned)r.mapX < (unsigned)mapW && (unsigned)r.mapY < (unsigned)mapH;
+    int hit = 0;
+    for (;;) {
+        if (inside && !superblocks[(r.mapY >> MAP_SUPERBLOCK_SHIFT) * superblocksW + (r.mapX >> MAP_SUPERBLOCK_SHIFT)]) {
+            leapBlock(&r, MAP_SUPERBLOCK_SHIFT);
+        } else if (inside && !blocks[(r.mapY >> MAP_BLOCK_SHIFT) * blocksW + (r.mapX >> MAP_BLOCK_SHIFT)]) {
+            leapBlock(&r, MAP_BLOCK_SHIFT);
+        } else {
+            // Occupied block: cell steps until a hit or the ray leaves it
+            int blockX = r.mapX >> MAP_BLOCK_SHIFT, blockY = r.mapY >> MAP_BLOCK_SHIFT;
+            for (;;) {
+                if (r.sideDistX < r.sideDistY) {
+                    r.sideDistX += r.deltaDistX;
+                    r.mapX += r.stepX;
+                    r.side = 0;
+                } else {
+                    r.sideDistY += r.deltaDistY;
+                    r.mapY += r.stepY;
+                    r.side = 1;
+                }
+                if ((unsigned)r.mapX >= (unsigned)mapW || (unsigned)r.mapY >= (unsigned)mapH) break;
+                if ((occupancy[r.mapY * stride + (r.mapX >> 6)] >> (r.mapX & 63)) & 1) {
+                    hit = 1;
+                    break;
+                }
+                if ((r.mapX >> MAP_BLOCK_SHIFT) != blockX || (r.mapY >> MAP_BLOCK_SHIFT) != blockY) break;
+            }
+            if (hit || (unsigned)r.mapX >= (unsigned)mapW || (unsigned)r.mapY >= (unsigned)mapH) break;
+            inside = 1;
+            continue;
+        }
+
+        // Leapt: test the cell the ray entered
+        if ((unsigned)r.mapX >= (unsigned)mapW || (unsigned)r.mapY >= (unsigned)mapH) {
+            break;
+        }
+        inside = 1;
+
+        if ((occupancy[r.mapY * stride + (r.mapX >> 6)] >> (r.mapX & 63)) & 1) {
+            hit = 1;
+            break;
+        }
+    }
+
+    return finishRay(hit, r.mapX, r.mapY, r.side, originX, originY, dirX, dirY);
+}
+
+// Size of the empty block around a cell inside the map: superblock or
+// block shift, or 0 when the cell's block holds a wall
+static inline int emptyBlockShift(int x, int y) {
+    if (!map.superblocks[(y >> MAP_SUPERBLOCK_SHIFT) * map.superblocksWidth + (x >> MAP_SUPERBLOCK_SHIFT)]) {
+        return MAP_SUPERBLOCK_SHIFT;
+    }
+    if (!map.blocks[(y >> MAP_BLOCK_SHIFT) * map.blocksWidth + (x >> MAP_BLOCK_SHIFT)]) return MAP_BLOCK_SHIFT;
+    return 0;
+}
+
+static inline int cellOccupied(int x, int y) {
+    return (map.occupancy[y * map.occupancyStride + (x >> 6)] >> (x & 63)) & 1;
+}
+
+// Float march: the double one with single-precision state
+typedef struct {
+    int mapX, mapY;
+    int stepX, stepY;
+    float sideDistX, sideDistY;
+    float deltaDistX, deltaDistY;
+    float absDirX, absDirY;
+    int side;
+} RayMarchFloat;
+
+static inline void leapBlockFloat(RayMarchFloat *r, int shift) {
+    int size = 1 << shift;
+    int blockX = r->mapX & ~(size - 1), blockY = r->mapY & ~(size - 1);
+    int insideX = r->stepX > 0 ? blockX + size - 1 - r->mapX : r->mapX - blockX;
+    int insideY = r->stepY > 0 ? blockY + size - 1 - r->mapY : r->mapY - blockY;
+    float exitX = r->sideDistX + insideX * r->deltaDistX;
+    float exitY = r->sideDistY + insideY * r->deltaDistY;
+    if (exitX < exitY) {
+        int crossY = exitX >= r->sideDistY ? (int)((exitX - r->sideDistY) * r->absDirY) + 1 : 0;
+        if (crossY > insideY) crossY = insideY;
+        r->mapY += crossY * r->stepY;
+        r->sideDistY += crossY * r->deltaDistY;
+        r->mapX += (insideX + 1) * r->stepX;
+        r->sideDistX = exitX + r->deltaDistX;
+        r->side = 0;
+    } else {
+        int crossX = 0;
+        if (exitY > r->sideDistX) {
+            float lines = (exitY - r->sideDistX) * r->absDirX;
+            crossX = (int)lines;
+            if (crossX < lines) crossX++;
+        }
+        if (crossX > insideX) crossX = insideX;
+        r->mapX += crossX * r->stepX;
+        r->sideDistX += crossX * r->deltaDistX;
+        r->mapY += (insideY + 1) * r->stepY;
+        r->sideDistY = exitY + r->deltaDistY;
+        r->side = 1;
+    }
+}
+
+static RayResult castRayFloat(double originX, double originY, double dirX, double dirY) {
+    const float posX = (float)originX, posY = (float)originY;
+    const float rayDirX = (float)dirX, rayDirY = (float)dirY;
+    RayMarchFloat r;
+    r.deltaDistX = (rayDirX == 0.0f) ? 1e30f : fabsf(1.0f / rayDirX);
+    r.deltaDistY = (rayDirY == 0.0f) ? 1e30f : fabsf(1.0f / rayDirY);
+    r.absDirX = fabsf(rayDirX);
+    r.absDirY = fabsf(rayDirY);
+    r.mapX = (int)posX;
+    r.mapY = (int)posY;
+    r.side = 0;
+    r.stepX = rayDirX < 0 ? -1 : 1;
+    r.stepY = rayDirY < 0 ? -1 : 1;
+    r.sideDistX = (rayDirX < 0 ? posX - r.mapX : r.mapX + 1.0f - posX) * r.deltaDistX;
+    r.sideDistY = (rayDirY < 0 ? posY - r.mapY : r.mapY + 1.0f - posY) * r.deltaDistY;
+
+    int inside = mapInside(r.mapX, r.mapY);
+    int hit = 0;
+    while (!hit) {
+        int shift = inside ? emptyBlockShift(r.mapX, r.mapY) : 0;
+        if (shift) {
+            leapBlockFloat(&r, shift);
+            if (!mapInside(r.mapX, r.mapY)) break;
+            hit = cellOccupied(r.mapX, r.mapY);
+        } else {
+            // Occupied block: cell steps until a hit or the ray leaves it
+            int blockX = r.mapX >> MAP_BLOCK_SHIFT, blockY = r.mapY >> MAP_BLOCK_SHIFT;
+            do {
+                if (r.sideDistX < r.sideDistY) {
+                    r.sideDistX += r.deltaDistX;
+                    r.mapX += r.stepX;
+                    r.side = 0;
+                } else {
+                    r.sideDistY += r.deltaDistY;
+                    r.mapY += r.stepY;
+                    r.side = 1;
+                }
+                if (!mapInside(r.mapX, r.mapY)) break;
+                hit = cellOccupied(r.mapX, r.mapY);
+            } while (!hit && (r.mapX >> MAP_BLOCK_SHIFT) == blockX && (r.mapY >> MAP_BLOCK_SHIFT) == blockY);
+            if (!mapInside(r.mapX, r.mapY)) break;
+        }
+        inside = 1;
+    }
+    if (!hit) return finishRay(0, 0, 0, 0, originX, originY, dirX, dirY);
+
+    RayResult result;
+    float distance, wallX;
+    if (r.side == 0) {
+        distance = (r.mapX - posX + (1 - r.stepX) / 2) / rayDirX;
+        wallX = posY + distance * rayDirY;
+    } else {
+        distance = (r.mapY - posY + (1 - r.stepY) / 2) / rayDirY;
+        wallX = posX + distance * rayDirX;
+    }
+    wallX -= floorf(wallX);
+    result.distance = distance;
+    result.wallX = wallX;
+    result.wallType = mapWall(r.mapX, r.mapY);
+    result.side = r.side;
+    result.mapX = r.mapX;
+    result.mapY = r.mapY;
+    return result;
+}
+
+// 16.16 fixed-point march. Positions and ray distances are 64-bit so the
+// largest maps fit. The direction keeps 24 fraction bits: at 16 bits the
+// small component of a near-axis ray is off by up to a few percent, and
+// so is its distance step. Crossings inside a leapt block are counted with
+// integer division, which is exact, so a leap ends where cell steps would.
+#define FIX_SHIFT 16
+#define FIX_ONE (1 << FIX_SHIFT)
+#define FIX_DIR_SHIFT 24
+// Distance step of an axis the ray never crosses; beyond any ray length
+#define FIX_FAR ((int64_t)1 << 40)
+
+typedef struct {
+    int mapX, mapY;
+    int stepX, stepY;
+    int64_t sideDistX, sideDistY;
+    int64_t deltaDistX, deltaDistY;
+    int side;
+} RayMarchFixed;
+
+static inline void leapBlockFixed(RayMarchFixed *r, int shift) {
+    int size = 1 << shift;
+    int blockX = r->mapX & ~(size - 1), blockY = r->mapY & ~(size - 1);
+    int insideX = r->stepX > 0 ? blockX + size - 1 - r->mapX : r->mapX - blockX;
+    int insideY = r->stepY > 0 ? blockY + size - 1 - r->mapY : r->mapY - blockY;
+    int64_t exitX = r->sideDistX + insideX * r->deltaDistX;
+    int64_t exitY = r->sideDistY + insideY * r->deltaDistY;
+    if (exitX < exitY) {
+        int64_t crossY = exitX >= r->sideDistY ? (exitX - r->sideDistY) / r->deltaDistY + 1 : 0;
+        if (crossY > insideY) crossY = insideY;
+        r->mapY += (int)crossY * r->stepY;
+        r->sideDistY += crossY * r->deltaDistY;
+        r->mapX += (insideX + 1) * r->stepX;
+        r->sideDistX = exitX + r->deltaDistX;
+        r->side = 0;
+    } else {
+        int64_t crossX = exitY > r->sideDistX ? (exitY - r->sideDistX + r->deltaDistX - 1) / r->deltaDistX : 0;
+        if (crossX > insideX) crossX = insideX;
+        r->mapX += (int)crossX * r->stepX;
+        r->sideDistX += crossX * r->deltaDistX;
+        r->mapY += (insideY + 1) * r->stepY;
+        r->sideDistY = exitY + r->deltaDistY;
+        r->side = 1;
+    }
+}
+
+static RayResult castRayFixed(double originX, double originY, double dirX, double dirY) {
+    const int64_t posX = (int64_t)(originX * FIX_ONE), posY = (int64_t)(originY * FIX_ONE);
+    const int32_t rayDirX = (int32_t)lrint(dirX * (1 << FIX_DIR_SHIFT));
+    const int32_t rayDirY = (int32_t)lrint(dirY * (1 << FIX_DIR_SHIFT));
+    RayMarchFixed r;
+    // 1 / |dir| in 16.16
+    r.deltaDistX = rayDirX == 0 ? FIX_FAR : ((int64_t)1 << (FIX_SHIFT + FIX_DIR_SHIFT)) / llabs(rayDirX);
+    r.deltaDistY = rayDirY == 0 ? FIX_FAR : ((int64_t)1 << (FIX_SHIFT + FIX_DIR_SHIFT)) / llabs(rayDirY);
+    r.mapX = (int)(posX >> FIX_SHIFT);
+    r.mapY = (int)(posY >> FIX_SHIFT);
+    r.side = 0;
+    r.stepX = rayDirX < 0 ? -1 : 1;
+    r.stepY = rayDirY < 0 ? -1 : 1;
+    int64_t cellX = (int64_t)r.mapX * FIX_ONE, cellY = (int64_t)r.mapY * FIX_ONE;
+    r.sideDistX = ((rayDirX < 0 ? posX - cellX : cellX + FIX_ONE - posX) * r.deltaDistX) >> FIX_SHIFT;
+    r.sideDistY = ((rayDirY < 0 ? posY - cellY : cellY + FIX_ONE - posY) * r.deltaDistY) >> FIX_SHIFT;
+
+    int inside = mapInside(r.mapX, r.mapY);
+    int hit = 0;
+    while (!hit) {
+        int shift = inside ? emptyBlockShift(r.mapX, r.mapY) : 0;
+        if (shift) {
+            leapBlockFixed(&r, shift);
+            if (!mapInside(r.mapX, r.mapY)) break;
+            hit = cellOccupied(r.mapX, r.mapY);
+        } else {
+            // Occupied block: cell steps until a hit or the ray leaves it
+            int blockX = r.mapX >> MAP_BLOCK_SHIFT, blockY = r.mapY >> MAP_BLOCK_SHIFT;
+            do {
+                if (r.sideDistX < r.sideDistY) {
+                    r.sideDistX += r.deltaDistX;
+                    r.mapX += r.stepX;
+                    r.side = 0;
+                } else {
+                    r.sideDistY += r.deltaDistY;
+                    r.mapY += r.stepY;
+                    r.side = 1;
+                }
+                if (!mapInside(r.mapX, r.mapY)) break;
+                hit = cellOccupied(r.mapX, r.mapY);
+            } while (!hit && (r.mapX >> MAP_BLOCK_SHIFT) == blockX && (r.mapY >> MAP_BLOCK_SHIFT) == blockY);
+            if (!mapInside(r.mapX, r.mapY)) break;
+        }
+        inside = 1;
+    }
+    if (!hit) return finishRay(0, 0, 0, 0, originX, originY, dirX, dirY);
+
+    // Distance to the grid line of the face that was hit. Taking it from
+    // sideDist would save the division, but that carries the truncation of
+    // every deltaDist added on the way: ~1e-2 of a cell after 1000 lines.
+    // Values that may be negative are scaled by multiplying, as a left
+    // shift of a negative number is undefined.
+    RayResult result;
+    int64_t distance;
+    if (r.side == 0) {
+        int64_t lineX = (int64_t)(r.mapX + (r.stepX < 0)) * FIX_ONE;
+        distance = (lineX - posX) * ((int64_t)1 << FIX_DIR_SHIFT) / rayDirX;
+    } else {
+        int64_t lineY = (int64_t)(r.mapY + (r.stepY < 0)) * FIX_ONE;
+        distance = (lineY - posY) * ((int64_t)1 << FIX_DIR_SHIFT) / rayDirY;
+    }
+    int64_t wallX = r.side == 0 ? posY + ((distance * rayDirY) >> FIX_DIR_SHIFT)
+                                : posX + ((distance * rayDirX) >> FIX_DIR_SHIFT);
+    result.distance = (double)distance / FIX_ONE;
+    result.wallX = (double)(wallX & (FIX_ONE - 1)) / FIX_ONE;
+    result.wallType = mapWall(r.mapX, r.mapY);
+    result.side = r.side;
+    result.mapX = r.mapX;
+    result.mapY = r.mapY;
+    return result;
+}
+
+#ifndef RAYCAST_PRECISION
+#define RAYCAST_PRECISION RAY_PRECISION_DOUBLE
+#endif
+
+static RayPrecision precision = RAYCAST_PRECISION;
+
+// Cast from a point along a world-space direction. For camera-plane rays
+// (forward component 1) the distance returned is perpendicular to the
+// view plane, which is what keeps walls free of fisheye distortion.
+RayResult castRayFrom(double originX, double originY, double dirX, double dirY) {
+    switch (precision) {
+    case RAY_PRECISION_FLOAT: return castRayFloat(originX, originY, dirX, dirY);
+    case RAY_PRECISION_FIXED: return castRayFixed(originX, originY, dirX, dirY);
+    default: return castRayDouble(originX, originY, dirX, dirY);
+    }
+}
+
+static const char *const precisionNames[] = { "double", "float", "fixed" };
+
+// Pick the march arithmetic by name ("double", "float", "fixed"); 0 if unknown
+int rayCastPrecisionSelect(const char *name) {
+    for (int i = 0; i < 3; ++i) {
+        if (strcmp(name, precisionNames[i]) == 0) {
+            precision = (RayPrecision)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *rayCastPrecisionName(void) {
+    return precisionNames[precision];
+}
+
+RayPrecision rayCastPrecision(void) {
+    return precision;
+}
+
+typedef void (*CastRaysFn)(double originX, double originY, const double *dirX, const double *dirY,
+                           int count, const RayHits *hits);
+
+static void castRaysScalar(double originX, double originY, const double *dirX, const double *dirY,
+                           int count, const RayHits *hits) {
+    for (int i = 0; i < count; ++i) {
+        storeHit(hits, i, castRayFrom(originX, originY, dirX[i], dirY[i]));
+    }
+}
+
+#ifdef RAYCAST_X86
+// 4 rays per group in AVX lanes, with the block lookups and the occupancy
+// test as masked gathers. A leap over a 1-cell block is exactly one cell
+// step, so lanes can leap by different sizes in the same iteration.
+__attribute__((target("avx2")))
+static void castRaysAVX2(double originX, double originY, const double *dirX, const double *dirY,
+                         int count, const RayHits *hits) {
+    const long long *occupancy = (const long long*)map.occupancy;
+    const int *blocks = (const int*)map.blocks, *superblocks = (const int*)map.superblocks;
+    const __m128i mapW = _mm_set1_epi32(map.width), mapH = _mm_set1_epi32(map.height);
+    const __m128i stride = _mm_set1_epi32(map.occupancyStride);
+    const __m128i blocksW = _mm_set1_epi32(map.blocksWidth), superblocksW = _mm_set1_epi32(map.superblocksWidth);
+    const __m128i byteMask = _mm_set1_epi32(0xFF), zeroI = _mm_setzero_si128(), allI = _mm_set1_epi32(-1);
+    const __m128i sizeOne = _mm_set1_epi32(1);
+    const __m128i sizeBlock = _mm_set1_epi32(1 << MAP_BLOCK_SHIFT), sizeSuper = _mm_set1_epi32(1 << MAP_SUPERBLOCK_SHIFT);
+    const __m128i lowBits = _mm_set1_epi32(63);
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0), allD = _mm256_castsi256_pd(_mm256_set1_epi32(-1));
+    // Low 32 bits of each 64-bit lane, to narrow double-lane masks
+    const __m256i narrow = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256d minusOne = _mm256_set1_pd(-1.0), farAway = _mm256_set1_pd(1e30);
+    const int startCellX = (int)originX, startCellY = (int)originY;
+    const double startX = startCellX, startY = startCellY;
+    const int startInside = (unsigned)startCellX < (unsigned)map.width && (unsigned)startCellY < (unsigned)map.height;
+    int group = 0;
+    for (; group + 4 <= count; group += 4) {
+        // startMarch() in the lanes; all rays share the start cell
+        __m256d dx = _mm256_loadu_pd(dirX + group), dy = _mm256_loadu_pd(dirY + group);
+        __m256d negX = _mm256_cmp_pd(dx, zero, _CMP_LT_OQ), negY = _mm256_cmp_pd(dy, zero, _CMP_LT_OQ);
+        __m256d stepX = _mm256_blendv_pd(one, minusOne, negX), stepY = _mm256_blendv_pd(one, minusOne, negY);
+        __m256d stepXPositive = _mm256_andnot_pd(negX, allD), stepYPositive = _mm256_andnot_pd(negY, allD);
+        __m256d deltaDistX = _mm256_blendv_pd(_mm256_andnot_pd(signBit, _mm256_div_pd(one, dx)), farAway,
+                                              _mm256_cmp_pd(dx, zero, _CMP_EQ_OQ));
+        __m256d deltaDistY = _mm256_blendv_pd(_mm256_andnot_pd(signBit, _mm256_div_pd(one, dy)), farAway,
+                                              _mm256_cmp_pd(dy, zero, _CMP_EQ_OQ));
+        __m256d absDirX = _mm256_andnot_pd(signBit, dx), absDirY = _mm256_andnot_pd(signBit, dy);
+        __m256d sideDistX = _mm256_mul_pd(_mm256_blendv_pd(_mm256_set1_pd(startX + 1.0 - originX),
+                                                           _mm256_set1_pd(originX - startX), negX), deltaDistX);
+        __m256d sideDistY = _mm256_mul_pd(_mm256_blendv_pd(_mm256_set1_pd(startY + 1.0 - originY),
+                                                           _mm256_set1_pd(originY - startY), negY), deltaDistY);
+        __m256d mapX = _mm256_set1_pd(startX), mapY = _mm256_set1_pd(startY);
+        __m256d side = zero;
+
+        // Lane masks as 4 x 32-bit
+        __m128i cellX = _mm_set1_epi32(startCellX), cellY = _mm_set1_epi32(startCellY);
+        __m128i inside = startInside ? allI : zeroI;
+        __m128i active = allI, hit = zeroI, hitX = zeroI, hitY = zeroI;
+        __m256d hitSide = zero;
+        // Set while every live lane is cell-stepping inside the block it
+        // last looked up, as the scalar march's inner loop does
+        int stepping = 0;
+        while (_mm_movemask_epi8(active)) {
+            __m128i lastBlockX = _mm_srai_epi32(cellX, MAP_BLOCK_SHIFT), lastBlockY = _mm_srai_epi32(cellY, MAP_BLOCK_SHIFT);
+            __m128i sizeI = sizeOne;
+            if (!stepping) {
+                // Block size per lane: 64 or 8 over empty space, 1 inside occupied blocks
+                __m128i lookup = inside;
+                __m128i superIndex = _mm_add_epi32(_mm_mullo_epi32(_mm_srai_epi32(cellY, MAP_SUPERBLOCK_SHIFT), superblocksW),
+                                                   _mm_srai_epi32(cellX, MAP_SUPERBLOCK_SHIFT));
+                __m128i blockIndex = _mm_add_epi32(_mm_mullo_epi32(lastBlockY, blocksW), lastBlockX);
+                __m128i superOccupied = _mm_and_si128(_mm_mask_i32gather_epi32(zeroI, superblocks, superIndex, lookup, 1), byteMask);
+                __m128i blockOccupied = _mm_and_si128(_mm_mask_i32gather_epi32(zeroI, blocks, blockIndex, lookup, 1), byteMask);
+                __m128i superEmpty = _mm_and_si128(lookup, _mm_cmpeq_epi32(superOccupied, zeroI));
+                __m128i blockEmpty = _mm_and_si128(lookup, _mm_cmpeq_epi32(blockOccupied, zeroI));
+                sizeI = _mm_blendv_epi8(_mm_blendv_epi8(sizeOne, sizeBlock, blockEmpty), sizeSuper, superEmpty);
+                stepping = _mm_testz_si128(_mm_or_si128(blockEmpty, superEmpty), active);
+            }
+
+            if (stepping) {
+                // One grid line per lane (y wins ties)
+                __m256d crossesX = _mm256_cmp_pd(sideDistX, sideDistY, _CMP_LT_OQ);
+                __m256d crossesY = _mm256_andnot_pd(crossesX, allD);
+                mapX = _mm256_add_pd(mapX, _mm256_and_pd(crossesX, stepX));
+                sideDistX = _mm256_add_pd(sideDistX, _mm256_and_pd(crossesX, deltaDistX));
+                mapY = _mm256_add_pd(mapY, _mm256_and_pd(crossesY, stepY));
+                sideDistY = _mm256_add_pd(sideDistY, _mm256_and_pd(crossesY, deltaDistY));
+                side = _mm256_and_pd(crossesY, one);
+            } else {
+                __m256d sizeV = _mm256_cvtepi32_pd(sizeI), last = _mm256_sub_pd(sizeV, one);
+                // Block origin; for size 1 (the only size outside the map) it is the cell itself
+                __m128i alignMask = _mm_sub_epi32(zeroI, sizeI);
+                __m256d blockX = _mm256_cvtepi32_pd(_mm_and_si128(cellX, alignMask));
+                __m256d blockY = _mm256_cvtepi32_pd(_mm_and_si128(cellY, alignMask));
+                __m256d insideX = _mm256_blendv_pd(_mm256_sub_pd(mapX, blockX), _mm256_sub_pd(_mm256_add_pd(blockX, last), mapX), stepXPositive);
+                __m256d insideY = _mm256_blendv_pd(_mm256_sub_pd(mapY, blockY), _mm256_sub_pd(_mm256_add_pd(blockY, last), mapY), stepYPositive);
+                __m256d exitX = _mm256_add_pd(sideDistX, _mm256_mul_pd(insideX, deltaDistX));
+                __m256d exitY = _mm256_add_pd(sideDistY, _mm256_mul_pd(insideY, deltaDistY));
+                __m256d exitsX = _mm256_cmp_pd(exitX, exitY, _CMP_LT_OQ);
+
+                // Leaving through x: the y lines crossed first (y wins ties)
+                __m256d crossY = _mm256_and_pd(_mm256_cmp_pd(exitX, sideDistY, _CMP_GE_OQ),
+                    _mm256_add_pd(_mm256_round_pd(_mm256_mul_pd(_mm256_sub_pd(exitX, sideDistY), absDirY), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), one));
+                crossY = _mm256_min_pd(crossY, insideY);
+                // Leaving through y: the x lines crossed strictly before
+                __m256d lines = _mm256_mul_pd(_mm256_sub_pd(exitY, sideDistX), absDirX);
+                __m256d crossX = _mm256_round_pd(lines, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                crossX = _mm256_add_pd(crossX, _mm256_and_pd(_mm256_cmp_pd(crossX, lines, _CMP_LT_OQ), one));
+                crossX = _mm256_and_pd(_mm256_cmp_pd(exitY, sideDistX, _CMP_GT_OQ), crossX);
+                crossX = _mm256_min_pd(crossX, insideX);
+
+                mapX = _mm256_blendv_pd(_mm256_add_pd(mapX, _mm256_mul_pd(crossX, stepX)),
+                                        _mm256_add_pd(mapX, _mm256_mul_pd(_mm256_add_pd(insideX, one), stepX)), exitsX);
+                mapY = _mm256_blendv_pd(_mm256_add_pd(mapY, _mm256_mul_pd(_mm256_add_pd(insideY, one), stepY)),
+                                        _mm256_add_pd(mapY, _mm256_mul_pd(crossY, stepY)), exitsX);
+                sideDistX = _mm256_blendv_pd(_mm256_add_pd(sideDistX, _mm256_mul_pd(crossX, deltaDistX)),
+                                             _mm256_add_pd(exitX, deltaDistX), exitsX);
+                sideDistY = _mm256_blendv_pd(_mm256_add_pd(exitY, deltaDistY),
+                                             _mm256_add_pd(sideDistY, _mm256_mul_pd(crossY, deltaDistY)), exitsX);
+                side = _mm256_andnot_pd(exitsX, one);
+            }
+
+            // Leave the map or hit: the lane is done
+            cellX = _mm256_cvttpd_epi32(mapX);
+            cellY = _mm256_cvttpd_epi32(mapY);
+            __m128i insideMap = _mm_and_si128(
+                _mm_andnot_si128(_mm_cmplt_epi32(cellX, zeroI), _mm_cmpgt_epi32(mapW, cellX)),
+                _mm_andnot_si128(_mm_cmplt_epi32(cellY, zeroI), _mm_cmpgt_epi32(mapH, cellY)));
+            __m128i wordIndex = _mm_add_epi32(_mm_mullo_epi32(cellY, stride), _mm_srai_epi32(cellX, 6));
+            __m256i words = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), occupancy, wordIndex,
+                                                        _mm256_cvtepi32_epi64(insideMap), 8);
+            __m256i bits = _mm256_srlv_epi64(words, _mm256_cvtepi32_epi64(_mm_and_si128(cellX, lowBits)));
+            __m256i set = _mm256_cmpeq_epi64(_mm256_and_si256(bits, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1));
+            __m128i wall = _mm_and_si128(insideMap, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(set, narrow)));
+            // Lanes finishing now keep their cell and side. Finished lanes
+            // march on (with lookups masked by the map bounds only), which
+            // keeps the lane masks out of the step and gather chains.
+            __m128i done = _mm_andnot_si128(_mm_andnot_si128(wall, insideMap), active);
+            __m256d doneD = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(done));
+            hitX = _mm_blendv_epi8(hitX, cellX, done);
+            hitY = _mm_blendv_epi8(hitY, cellY, done);
+            hitSide = _mm256_blendv_pd(hitSide, side, doneD);
+            hit = _mm_or_si128(hit, _mm_and_si128(wall, active));
+            active = _mm_andnot_si128(done, active);
+            inside = insideMap;
+
+            // Keep stepping while no live lane has left its block
+            if (stepping) {
+                __m128i moved = _mm_or_si128(_mm_xor_si128(_mm_srai_epi32(cellX, MAP_BLOCK_SHIFT), lastBlockX),
+                                             _mm_xor_si128(_mm_srai_epi32(cellY, MAP_BLOCK_SHIFT), lastBlockY));
+                stepping = _mm_testz_si128(moved, active);
+            }
+        }
+
+        // finishRay() in the lanes
+        __m256d hitD = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(hit));
+        __m256d sideY = _mm256_cmp_pd(hitSide, zero, _CMP_NEQ_OQ);
+        __m256d nearX = _mm256_and_pd(negX, one), nearY = _mm256_and_pd(negY, one);
+        __m256d distX = _mm256_div_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_cvtepi32_pd(hitX), _mm256_set1_pd(originX)), nearX), dx);
+        __m256d distY = _mm256_div_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_cvtepi32_pd(hitY), _mm256_set1_pd(originY)), nearY), dy);
+        __m256d distance = _mm256_blendv_pd(distX, distY, sideY);
+        __m256d wallX = _mm256_blendv_pd(_mm256_add_pd(_mm256_set1_pd(originY), _mm256_mul_pd(distance, dy)),
+                                         _mm256_add_pd(_mm256_set1_pd(originX), _mm256_mul_pd(distance, dx)), sideY);
+        wallX = _mm256_sub_pd(wallX, _mm256_floor_pd(wallX));
+        _mm256_storeu_pd(hits->distance + group, _mm256_blendv_pd(_mm256_set1_pd(MAX_DISTANCE), distance, hitD));
+        _mm256_storeu_pd(hits->wallX + group, _mm256_and_pd(hitD, wallX));
+        _mm_storeu_si128((__m128i*)(hits->side + group), _mm_and_si128(hit, _mm256_cvtpd_epi32(hitSide)));
+        __m128i outX = _mm_blendv_epi8(allI, hitX, hit), outY = _mm_blendv_epi8(allI, hitY, hit);
+        _mm_storeu_si128((__m128i*)(hits->mapX + group), outX);
+        _mm_storeu_si128((__m128i*)(hits->mapY + group), outY);
+        int cx[4], cy[4];
+        _mm_storeu_si128((__m128i*)cx, outX);
+        _mm_storeu_si128((__m128i*)cy, outY);
+        for (int k = 0; k < 4; ++k) {
+            size_t cell = (size_t)cy[k] * map.width + cx[k];
+            hits->wallType[group + k] = cx[k] >= 0 ? map.walls[cell] : 1;
+            hits->textureId[group + k] = cx[k] >= 0 ? map.textures[cell] : 0;
+        }
+    }
+    castRaysScalar(originX, originY, dirX + group, dirY + group, count - group,
+                   &(RayHits){ hits->distance + group, hits->wallX + group, hits->wallType + group,
+                               hits->side + group, hits->textureId + group, hits->mapX + group, hits->mapY + group });
+}
+#endif
+
+static CastRaysFn castRaysFn = castRaysScalar;
+static const char *kernelName = "scalar";
+
+// Use the kernel set named by rasterSelect(); 0 if unsupported here
+int rayCastSelect(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        castRaysFn = castRaysScalar;
+        kernelName = "scalar";
+        return 1;
+    }
+#ifdef RAYCAST_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        castRaysFn = castRaysScalar;
+        kernelName = "scalar";
+        return 1;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        castRaysFn = castRaysAVX2;
+        kernelName = "avx2";
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+const char *rayCastKernelName(void) {
+    return kernelName;
+}
+
+// Cast count rays from one point; results go to hits[0..count)
+// The AVX2 kernel marches in double; the other precisions cast one by one.
+void castRays(double originX, double originY, const double *dirX, const double *dirY, int count, const RayHits *hits) {
+    if (count <= 0) return;
+    if (precision == RAY_PRECISION_DOUBLE) {
+        castRaysFn(originX, originY, dirX, dirY, count, hits);
+    } else {
+        castRaysScalar(originX, originY, dirX, dirY, count, hits);
+    }
+}
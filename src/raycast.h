@@ -0,0 +1,45 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include "raywhen.h"
+
+// Raycasting result structure
+typedef struct {
+    double distance;
+    int wallType;
+    int side; // 0 for horizontal walls, 1 for vertical walls
+    double wallX; // Where on the wall the ray hit (for texture mapping)
+    int mapX, mapY; // Cell that was hit (-1 if the ray left the map)
+} RayResult;
+
+// Results of castRays() as structure-of-arrays, one entry per ray. Each
+// field matches RayResult; textureId is the wall texture of the hit cell
+// (0 if the ray left the map).
+typedef struct {
+    double *distance;
+    double *wallX;
+    int *wallType;
+    int *side;
+    int *textureId;
+    int *mapX, *mapY;
+} RayHits;
+
+// Arithmetic of the ray march. Double is the reference; float and 16.16
+// fixed point are for CPUs where double is slow. The startup default can
+// be changed at build time with -DRAYCAST_PRECISION=RAY_PRECISION_FIXED.
+typedef enum {
+    RAY_PRECISION_DOUBLE,
+    RAY_PRECISION_FLOAT,
+    RAY_PRECISION_FIXED
+} RayPrecision;
+
+// Function declarations
+RayResult castRayFrom(double originX, double originY, double dirX, double dirY);
+void castRays(double originX, double originY, const double *dirX, const double *dirY, int count, const RayHits *hits);
+int rayCastSelect(const char *name);
+const char *rayCastKernelName(void);
+int rayCastPrecisionSelect(const char *name);
+const char *rayCastPrecisionName(void);
+RayPrecision rayCastPrecision(void);
+
+#endif // RAYCAST_H
@@ -0,0 +1,238 @@
+// Raycast accuracy report: casts a dense sweep of rays from positions all
+// over each map with the float and 16.16 fixed-point marches and compares
+// hit cell, side, wallX and distance with the double march. Mismatches are
+// also broken down by how far the ray origin is from the map origin, since
+// both reduced precisions lose fraction bits as coordinates grow. It then
+// checks the ray cache against castRays() on views along the four axis
+// headings, and exits 1 if any cached ray differs.
+#include "raywhen.h"
+#include "map.h"
+#include "raycast.h"
+#include "raycache.h"
+
+// Global screen dimensions (unused, but the engine core expects them)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+#define MAX_CHECK_MAPS 16
+// Columns and positions of the ray cache check
+#define CACHE_CHECK_WIDTH 320
+#define CACHE_CHECK_POSITIONS 64
+// Origin ranges of the breakdown: [0, 64), [64, 256), ... by powers of 4
+#define RANGE_COUNT 6
+
+typedef struct {
+    long long rays;
+    long long cellMismatches;    // different hit cell (or hit vs miss)
+    long long sideMismatches;    // same cell, other face
+    long long compared;          // same cell and face: wallX and distance compared
+    double wallXMax, wallXSum;   // absolute error, in wall widths (wrapped at 1)
+    double distanceMax;          // relative error
+} Accuracy;
+
+static int rangeOf(double x, double y) {
+    double m = x > y ? x : y;
+    int range = 0;
+    for (double limit = 64.0; m >= limit && range < RANGE_COUNT - 1; limit *= 4.0) range++;
+    return range;
+}
+
+static void rangeName(int range, char *out, size_t size) {
+    long lo = range == 0 ? 0 : 64L << (2 * (range - 1));
+    if (range == RANGE_COUNT - 1) {
+        snprintf(out, size, ">= %ld", lo);
+    } else {
+        snprintf(out, size, "%ld-%ld", lo, 64L << (2 * range));
+    }
+}
+
+static void record(Accuracy *a, const RayResult *ref, const RayResult *r) {
+    a->rays++;
+    if (r->mapX != ref->mapX || r->mapY != ref->mapY) {
+        a->cellMismatches++;
+        return;
+    }
+    if (ref->mapX < 0) return; // both missed
+    if (r->side != ref->side) {
+        a->sideMismatches++;
+        return;
+    }
+    // wallX wraps: 0.9999 and 0.0001 are neighbours
+    double e = fabs(r->wallX - ref->wallX);
+    if (e > 0.5) e = 1.0 - e;
+    a->compared++;
+    a->wallXSum += e;
+    if (e > a->wallXMax) a->wallXMax = e;
+    double d = fabs(r->distance - ref->distance) / (ref->distance > 1e-9 ? ref->distance : 1e-9);
+    if (d > a->distanceMax) a->distanceMax = d;
+}
+
+static void printAccuracy(const char *label, const Accuracy *a) {
+    if (a->rays == 0) return;
+    printf("  %-14s %10lld  %8.4f%%  %8.4f%%  %10.2e  %10.2e  %10.2e\n", label, a->rays,
+           100.0 * a->cellMismatches / a->rays, 100.0 * a->sideMismatches / a->rays,
+           a->wallXMax, a->compared ? a->wallXSum / a->compared : 0.0, a->distanceMax);
+}
+
+static void checkMap(const char *path, double step, int angles) {
+    if (!loadMapFromFile(path)) {
+        printf("%s: failed to load\n", path);
+        return;
+    }
+    // Positions on a lattice of step cells, offset off the grid lines, in
+    // open cells only; the step grows on big maps to keep the run short
+    double cellStep = step;
+    while ((double)map.width * map.height / (cellStep * cellStep) > 65536.0) cellStep *= 2.0;
+
+    static const char *const names[] = { "float", "fixed" };
+    Accuracy total[2], byRange[2][RANGE_COUNT];
+    memset(total, 0, sizeof(total));
+    memset(byRange, 0, sizeof(byRange));
+    long long positions = 0;
+    for (double y = cellStep * 0.37; y < map.height; y += cellStep) {
+        for (double x = cellStep * 0.61; x < map.width; x += cellStep) {
+            if (mapWall((int)x, (int)y) != 0) continue;
+            positions++;
+            int range = rangeOf(x, y);
+            for (int a = 0; a < angles; ++a) {
+                double angle = (a + 0.5) * (2.0 * M_PI / angles);
+                double dirX = cos(angle), dirY = sin(angle);
+                rayCastPrecisionSelect("double");
+                RayResult ref = castRayFrom(x, y, dirX, dirY);
+                for (int p = 0; p < 2; ++p) {
+                    rayCastPrecisionSelect(names[p]);
+                    RayResult r = castRayFrom(x, y, dirX, dirY);
+                    record(&total[p], &ref, &r);
+                    record(&byRange[p][range], &ref, &r);
+                }
+            }
+        }
+    }
+    rayCastPrecisionSelect("double");
+
+    printf("%s: %dx%d, %lld positions (every %g cells) x %d directions\n", path, map.width, map.height,
+           positions, cellStep, angles);
+    printf("  %-14s %10s  %9s  %9s  %10s  %10s  %10s\n", "", "rays", "cell", "side",
+           "wallX max", "wallX mean", "dist rel");
+    for (int p = 0; p < 2; ++p) {
+        printAccuracy(names[p], &total[p]);
+        for (int r = 0; r < RANGE_COUNT; ++r) {
+            if (byRange[p][r].rays == 0 || byRange[p][r].rays == total[p].rays) continue;
+            char label[32], range[24];
+            rangeName(r, range, sizeof(range));
+            snprintf(label, sizeof(label), "  at %s", range);
+            printAccuracy(label, &byRange[p][r]);
+        }
+    }
+}
+
+// Ray cache against castRays(), bit for bit, from open cells turning
+// through the axis headings. The centre column of those views runs along
+// a grid line, out of the map wherever the border is open. Each view is
+// drawn over a few frames so the cache fills and is read back, with a
+// slight turn in between. Returns the number of rays that differ.
+static long long checkCache(const char *path) {
+    static double dirX[CACHE_CHECK_WIDTH], dirY[CACHE_CHECK_WIDTH], angle[CACHE_CHECK_WIDTH];
+    static double distance[2][CACHE_CHECK_WIDTH], wallX[2][CACHE_CHECK_WIDTH];
+    static int wallType[2][CACHE_CHECK_WIDTH], side[2][CACHE_CHECK_WIDTH], textureId[2][CACHE_CHECK_WIDTH];
+    static int mapX[2][CACHE_CHECK_WIDTH], mapY[2][CACHE_CHECK_WIDTH];
+    static const double axisX[4] = { 1.0, 0.0, -1.0, 0.0 }, axisY[4] = { 0.0, 1.0, 0.0, -1.0 };
+    static const double turns[] = { 0.0, 0.0, 0.002, 0.0 };
+    const int frames = (int)(sizeof(turns) / sizeof(turns[0]));
+    RayHits hits[2];
+    for (int h = 0; h < 2; ++h) {
+        RayHits r = { distance[h], wallX[h], wallType[h], side[h], textureId[h], mapX[h], mapY[h] };
+        hits[h] = r;
+    }
+    if (!loadMapFromFile(path)) return 0;
+
+    RayCacheStats before, after;
+    rayCacheGetStats(&before);
+    int enabled = rayCacheEnabled;
+    rayCacheEnabled = 1;
+    rayCastPrecisionSelect("double");
+    double planeScale = tan(FOV / 2.0);
+    int cellStep = 1;
+    while ((long long)map.width * map.height / ((long long)cellStep * cellStep) > CACHE_CHECK_POSITIONS) cellStep++;
+    long long rays = 0, bad = 0;
+    int positions = 0;
+    for (int cy = 0; cy < map.height; cy += cellStep) {
+        for (int cx = 0; cx < map.width; cx += cellStep) {
+            if (mapWall(cx, cy) != 0) continue;
+            double x = cx + 0.5, y = cy + 0.5;
+            positions++;
+            rayCacheInvalidate();
+            for (int a = 0; a < 4; ++a) {
+                for (int f = 0; f < frames; ++f) {
+                    double heading = a * (M_PI / 2.0) + turns[f];
+                    // Exact axis directions when not turned
+                    double forwardX = turns[f] != 0.0 ? cos(heading) : axisX[a];
+                    double forwardY = turns[f] != 0.0 ? sin(heading) : axisY[a];
+                    for (int i = 0; i < CACHE_CHECK_WIDTH; ++i) {
+                        double camera = (2.0 * i / CACHE_CHECK_WIDTH - 1.0) * planeScale;
+                        dirX[i] = forwardX - forwardY * camera;
+                        dirY[i] = forwardY + forwardX * camera;
+                        angle[i] = heading + atan(camera);
+                    }
+                    rayCacheBeginFrame(x, y);
+                    castRaysCached(x, y, dirX, dirY, angle, CACHE_CHECK_WIDTH, &hits[0]);
+                    castRays(x, y, dirX, dirY, CACHE_CHECK_WIDTH, &hits[1]);
+                    for (int i = 0; i < CACHE_CHECK_WIDTH; ++i) {
+                        if (memcmp(&distance[0][i], &distance[1][i], sizeof(double)) != 0 ||
+                            memcmp(&wallX[0][i], &wallX[1][i], sizeof(double)) != 0 ||
+                            wallType[0][i] != wallType[1][i] || side[0][i] != side[1][i] ||
+                            textureId[0][i] != textureId[1][i] ||
+                            mapX[0][i] != mapX[1][i] || mapY[0][i] != mapY[1][i]) {
+                            bad++;
+                        }
+                    }
+                    rays += CACHE_CHECK_WIDTH;
+                }
+            }
+        }
+    }
+    rayCacheInvalidate();
+    rayCacheEnabled = enabled;
+
+    rayCacheGetStats(&after);
+    printf("%s: ray cache, %d positions x 4 axis headings: %lld rays, %lld from the cache, %lld mismatches\n",
+           path, positions, rays, after.hits - before.hits, bad);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    const char *maps[MAX_CHECK_MAPS];
+    int mapCount = 0;
+    double step = 0.25;
+    int angles = 256;
+    for (int i = 1; i < argc; ++i) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-map") == 0 && next) {
+            if (mapCount < MAX_CHECK_MAPS) maps[mapCount++] = next;
+            i++;
+        } else if (strcmp(argv[i], "-step") == 0 && next) {
+            step = atof(next); i++;
+            if (step <= 0.0) step = 0.25;
+        } else if (strcmp(argv[i], "-angles") == 0 && next) {
+            angles = atoi(next); i++;
+            if (angles < 1) angles = 1;
+        } else {
+            printf("Usage: %s [-map file.rwm]... [-step cells] [-angles n]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (mapCount == 0) {
+        maps[mapCount++] = "maps/map.rwm";
+        maps[mapCount++] = "maps/arena.rwm";
+        maps[mapCount++] = "maps/littlehouse.rwm";
+    }
+
+    printf("Float and 16.16 fixed-point raycasts against double\n"
+           "(cell: other hit cell or hit/miss; side: same cell, other face;\n"
+           " wallX in wall widths and relative distance over rays that agree)\n");
+    for (int m = 0; m < mapCount; ++m) checkMap(maps[m], step, angles);
+    printf("\n");
+    long long cacheMismatches = 0;
+    for (int m = 0; m < mapCount; ++m) cacheMismatches += checkCache(maps[m]);
+    return cacheMismatches ? 1 : 0;
+}
@@ -1,9 +1,12 @@
 #ifndef RAYWHEN_H
 #define RAYWHEN_H
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <math.h>
 #include <time.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,14 +16,30 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+#ifndef _WIN32
+// Minimal stand-ins for the Win32 types the engine core uses, so the
+// renderer, map, texture and player modules build headless on other platforms
+typedef uint32_t COLORREF;
+typedef void *HDC;
+typedef void *HWND;
+#define RGB(r, g, b) ((COLORREF)(((uint8_t)(r)) | (((uint32_t)(uint8_t)(g)) << 8) | (((uint32_t)(uint8_t)(b)) << 16)))
+#define GetRValue(c) ((uint8_t)(c))
+#define GetGValue(c) ((uint8_t)((c) >> 8))
+#define GetBValue(c) ((uint8_t)((c) >> 16))
+#define MAX_PATH 260
+#define VK_SHIFT 0x10
+#define VK_LEFT  0x25
+#define VK_UP    0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN  0x28
+#endif
+
 // Configuration constants
 #define MIN_SCREEN_WIDTH 640
 #define MIN_SCREEN_HEIGHT 480
 #define DEFAULT_SCREEN_WIDTH 1024
 #define DEFAULT_SCREEN_HEIGHT 768
-#define MAP_WIDTH 16
-#define MAP_HEIGHT 16
-#define MAX_TEXTURES 16
+#define MAX_TEXTURES 4096  // texture handles (see texlib.h)
 #define TEX_WIDTH 64
 #define TEX_HEIGHT 64
 #define FOV (M_PI / 3.0)  // 60 degrees
@@ -44,13 +63,15 @@
 extern int SCREEN_WIDTH;
 extern int SCREEN_HEIGHT;
 
-// Back buffer for double buffering
+#ifdef _WIN32
+// Back buffer for double buffering (GDI DIB section owned by raywin.c)
 extern HDC backDC;
 extern HBITMAP backBMP;
 extern HBITMAP backOldBMP;
 extern int backW;
 extern int backH;
 extern uint32_t *backPixels; // BGRA top-down
+#endif
 
 // Depth buffer for sprite occlusion
 extern double *depthBuffer;
@@ -62,8 +83,10 @@ static inline uint32_t colorref_to_bgra(COLORREF c) {
 }
 
 // Function declarations
+#ifdef _WIN32
 void ensureBackBuffer(HWND hwnd);
 void parseLaunchArgs(void);
 void drawDebugInfo(HDC hdc);
+#endif
 
 #endif // RAYWHEN_H
@@ -1,9 +1,17 @@
 #include "raywhen.h"
 #include "texture.h"
+#include "texstore.h"
+#include "texstream.h"
+#include "texcache.h"
 #include "map.h"
 #include "player.h"
 #include "enemy.h"
 #include "renderer.h"
+#include "framebuffer.h"
+#include "threadpool.h"
+#include "raster.h"
+#include "raycache.h"
+#include "profiler.h"
 #include <psapi.h>
 
 // Global screen dimensions (will be updated on resize)
@@ -23,7 +31,7 @@ int debugModeEnabled = 0;
 static char currentMapName[MAX_PATH] = "Default";
 
 // FPS tracking for debug display
-static DWORD lastFrameTime = 0;
+static double lastFrameTime = 0.0;
 static int frameCount = 0;
 static int currentFPS = 0;
 static DWORD fpsUpdateTime = 0;
@@ -36,9 +44,8 @@ int backW = 0;
 int backH = 0;
 uint32_t *backPixels = NULL; // BGRA top-down
 
-// Depth buffer for sprite occlusion (stores corrected distances for each screen column)
-double *depthBuffer = NULL;
-int depthW = 0;
+// Framebuffer view of the back buffer handed to the renderer
+static Framebuffer frameBuffer = {0};
 
 void ensureBackBuffer(HWND hwnd) {
 	if (!hwnd) return;
@@ -72,18 +79,17 @@ void ensureBackBuffer(HWND hwnd) {
 	ReleaseDC(hwnd, wndDC);
 	backW = SCREEN_WIDTH;
 	backH = SCREEN_HEIGHT;
+	framebufferWrap(&frameBuffer, backPixels, backW, backH, backW);
+	rendererSetView(backW, FOV);
 
 	// (Re)allocate depth buffer to match current width
-	if (depthW != SCREEN_WIDTH) {
-		if (depthBuffer) {
-			free(depthBuffer);
-			depthBuffer = NULL;
-		}
-		depthBuffer = (double*)malloc(sizeof(double) * SCREEN_WIDTH);
-		depthW = SCREEN_WIDTH;
-    }
+	ensureDepthBuffer(SCREEN_WIDTH);
 }
 
+// Texture pack and map named on the command line (the buffer is freed)
+static char packPath[MAX_PATH];
+static char launchMapPath[MAX_PATH];
+
 // Command-line parsing for launcher options
 void parseLaunchArgs(void) {
     char *cmd = GetCommandLineA();
@@ -115,6 +121,22 @@ void parseLaunchArgs(void) {
             tok = strtok(NULL, " \t\r\n");
             continue;
         }
+        if (strcmp(tok, "-threads") == 0 || strcmp(tok, "--threads") == 0) {
+            char *next = strtok(NULL, " \t\r\n");
+            if (next) {
+                int n = atoi(next);
+                if (n >= 0 && n <= MAX_RENDER_THREADS) renderThreadCount = n;
+            }
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
+        if (strcmp(tok, "-raycast") == 0) {
+            // Raycast arithmetic: double, float or fixed
+            char *next = strtok(NULL, " \t\r\n");
+            if (next) rayCastPrecisionSelect(next);
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
         if (strcmp(tok, "-debug") == 0 || strcmp(tok, "--debug") == 0) {
             debugModeEnabled = 1;
             tok = strtok(NULL, " \t\r\n");
@@ -123,7 +145,8 @@ void parseLaunchArgs(void) {
         if (strcmp(tok, "-map") == 0) {
             char *next = strtok(NULL, " \t\r\n");
             if (next) {
-                loadMapFromFile(next);
+                strncpy(launchMapPath, next, MAX_PATH - 1);
+                launchMapPath[MAX_PATH - 1] = '\0';
                 // Extract filename for debug display
                 char *filename = strrchr(next, '\\');
                 if (filename) filename++;
@@ -134,6 +157,26 @@ void parseLaunchArgs(void) {
             tok = strtok(NULL, " \t\r\n");
             continue;
         }
+        if (strcmp(tok, "-pack") == 0) {
+            char *next = strtok(NULL, " \t\r\n");
+            if (next) {
+                strncpy(packPath, next, MAX_PATH - 1);
+                packPath[MAX_PATH - 1] = '\0';
+                texturePackPath = packPath;
+            }
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
+        if (strcmp(tok, "-no-pack") == 0) {
+            texturePackPath = NULL;
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
+        if (strcmp(tok, "-stream") == 0 || strcmp(tok, "--stream") == 0) {
+            textureStreaming = 1;
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
         if ((strcmp(tok, "-w") == 0 || strcmp(tok, "--width") == 0)) {
             char *next = strtok(NULL, " \t\r\n");
             if (next) {
@@ -161,6 +204,27 @@ void parseLaunchArgs(void) {
             tok = strtok(NULL, " \t\r\n");
             continue;
         }
+        if (strcmp(tok, "--texture-budget-mb") == 0) {
+            char *next = strtok(NULL, " \t\r\n");
+            if (next) {
+                int mb = atoi(next);
+                if (mb >= 0) textureBudgetBytes = (size_t)mb * 1024 * 1024;
+            }
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
+        if (strcmp(tok, "-ray-cache") == 0) {
+            // Reuse rays while the view only turns
+            rayCacheEnabled = 1;
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
+        if (strcmp(tok, "--profile-csv") == 0) {
+            char *next = strtok(NULL, " \t\r\n");
+            if (next) profilerOpenCsv(next);
+            tok = strtok(NULL, " \t\r\n");
+            continue;
+        }
         if (strcmp(tok, "-fullscreen") == 0 || strcmp(tok, "--fullscreen") == 0) {
             fullscreenMode = 1;
             tok = strtok(NULL, " \t\r\n");
@@ -254,7 +318,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             }
             
             // Update player movement
+            profileBegin(PROFILE_MOVEMENT);
             updatePlayerMovement(keys);
+            profileEnd(PROFILE_MOVEMENT);
             
             // Only redraw if something actually changed or a flash is active
             if (playerX != oldX || playerY != oldY || playerAngle != oldAngle || flashFrames > 0) {
@@ -288,20 +354,27 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
             ensureBackBuffer(hwnd);
-            // Draw into back buffer
-            renderScene(backDC);
+            // Draw into back buffer (flush pending GDI text before touching the DIB)
+            GdiFlush();
+            renderScene(&frameBuffer);
             // Draw debug info if enabled
             if (debugModeEnabled) {
                 drawDebugInfo(backDC);
             }
             // Blit to screen
+            profileBegin(PROFILE_BLIT);
             BitBlt(hdc, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, backDC, 0, 0, SRCCOPY);
+            profileEnd(PROFILE_BLIT);
             EndPaint(hwnd, &ps);
+            profilerEndFrame();
         } break;
 
         case WM_DESTROY:
             // Cleanup software renderer resources
-            if (depthBuffer) { free(depthBuffer); depthBuffer = NULL; depthW = 0; }
+            textureStreamShutdown();
+            freeDepthBuffer();
+            threadPoolShutdown();
+            profilerCloseCsv();
             PostQuitMessage(0);
             return 0;
         
@@ -331,32 +404,44 @@ void drawDebugInfo(HDC hdc) {
         memoryUsage = pmc.WorkingSetSize / 1024; // Convert to KB
     }
     
-    // Get CPU usage (simplified - just show frame time)
-    DWORD frameTime = currentTime - lastFrameTime;
-    lastFrameTime = currentTime;
+    // High-resolution frame time (GetTickCount only ticks every ~16 ms)
+    double now = profilerNow();
+    double frameTime = (lastFrameTime > 0.0) ? now - lastFrameTime : 0.0;
+    lastFrameTime = now;
     
     // Set text color to white
     SetTextColor(hdc, RGB(255, 255, 255));
     SetBkMode(hdc, TRANSPARENT);
     
     // Draw debug info in top-left corner
-    char debugText[512];
-    sprintf(debugText, 
+    char debugText[2048];
+    int len = sprintf(debugText, 
         "FPS: %d\n"
         "Memory: %zu KB\n"
-        "Frame Time: %lu ms\n"
+        "Frame Time: %.2f ms\n"
         "Resolution: %dx%d\n"
         "Player: (%.1f, %.1f)\n"
         "Angle: %.1f°\n"
-        "Map: %s",
+        "Map: %s\n"
+        "Streaming: %d textures\n",
         currentFPS,
         memoryUsage,
         frameTime,
         SCREEN_WIDTH, SCREEN_HEIGHT,
         playerX, playerY,
         playerAngle * 180.0 / 3.14159,
-        currentMapName
+        currentMapName,
+        textureStreamPending()
     );
+
+    // Texture cache residency and hit/miss/eviction counts
+    len += textureCacheFormat(debugText + len, sizeof(debugText) - len);
+
+    // Rolling per-phase timings, in a fixed-width font so the columns line up
+    debugText[len++] = '\n';
+    debugText[len++] = '\n';
+    profilerFormat(debugText + len, sizeof(debugText) - len);
+    HFONT oldFont = (HFONT)SelectObject(hdc, GetStockObject(ANSI_FIXED_FONT));
     
     // Draw text with black outline for better visibility
     RECT textRect = {10, 10, SCREEN_WIDTH - 10, SCREEN_HEIGHT - 10};
@@ -374,12 +459,18 @@ void drawDebugInfo(HDC hdc) {
     // Draw white text
     SetTextColor(hdc, RGB(255, 255, 255));
     DrawTextA(hdc, debugText, -1, &textRect, DT_LEFT | DT_TOP | DT_NOCLIP);
+    SelectObject(hdc, oldFont);
 }
 
 // Entry point
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow) {
     parseLaunchArgs();
+    threadPoolInit(renderThreadCount);
+    rasterInit();
+    // Loaded after the pool is up (textures decode on it) and after every
+    // option is parsed (the texture pack choice applies to it)
+    if (launchMapPath[0]) loadMapFromFile(launchMapPath);
     const char g_szClassName[] = "RaycasterWinClass";
 
     WNDCLASS wc = {0};
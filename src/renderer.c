@@ -1,8 +1,15 @@
 #include "renderer.h"
 #include "texture.h"
+#include "texstore.h"
+#include "texcache.h"
 #include "map.h"
 #include "player.h"
 #include "enemy.h"
+#include "threadpool.h"
+#include "raster.h"
+#include "raycache.h"
+#include "lighting.h"
+#include "profiler.h"
 
 // External wallColors from texture.c
 extern COLORREF wallColors[];
@@ -11,231 +18,366 @@ extern COLORREF wallColors[];
 int simpleShadingMode = 0;
 int perfExplicitlySet = 0; // set to 1 if -perf/--no-perf provided
 
+// Render worker threads (-threads N; 0 = one per CPU, 1 = single-threaded)
+int renderThreadCount = 1;
+
+// Work granularity for the parallel passes
+#define WALL_STRIP_WIDTH 16
+#define FLOOR_BAND_HEIGHT 8
+
+// HUD elements drawn over the world (gun, minimap); the world passes skip
+// these pixels so every pixel is written once
+#define MAX_HUD_RECTS 2
+
+// Most map cells across the minimap; larger maps scroll with the player
+#define MINIMAP_VIEW_CELLS 32
+
+typedef struct {
+    int x0, y0, x1, y1; // [x0,x1) x [y0,y1)
+} ScreenRect;
+
+// Per-frame state shared by the row and column passes
+typedef struct {
+    const Framebuffer *fb;
+    int horizon;
+    ScreenRect hud[MAX_HUD_RECTS];
+    int hudCount;
+    int rowBegin, rowEnd;              // rows covered by the current sky/floor pass
+    double angle;                      // view direction (player heading)
+    double dirX, dirY;                 // view direction (player cos/sin)
+    double rayDirLeftX, rayDirLeftY;   // camera-plane ray through the left edge
+    double rayDirRightX, rayDirRightY; // camera-plane ray through the right edge
+    double planeStepX, planeStepY;     // ray direction change per screen column
+    double planeWidth;                 // length of the camera plane (left to right edge)
+    FloorSampler floor;
+} FrameContext;
+
+// Texel offset of every texture handle for the floor pass (-1 = not loaded)
+static int floorTextureTexels[MAX_TEXTURES];
+
 // No adaptive quality - performance mode is only set via command line
 
-// Improved DDA raycasting algorithm with optimized trigonometric calculations
+// Camera-space lateral offset of every screen column's ray: the ray for
+// column x is forward + right * cameraRays[x]. Depends only on the
+// resolution and FOV, so it is rebuilt on resize rather than per frame.
+static double *cameraRays = NULL;
+static double *cameraAngles = NULL; // angle of each column's ray off the heading
+static int cameraRaysWidth = 0;
+static double cameraRaysFov = 0.0;
+
+// Rows [wallStart[x], wallEnd[x]) of each column are covered by wall; the
+// sky/floor pass fills only the rest. Sized alongside cameraRays.
+static int *wallStart = NULL;
+static int *wallEnd = NULL;
+
+// Span bounds per wall strip, so the sky/floor pass can fill or skip
+// whole strips and only test single columns where span edges cross a row
+typedef struct {
+    int minStart, maxStart;
+    int minEnd, maxEnd;
+} StripSpans;
+static StripSpans *stripSpans = NULL;
+
+void rendererSetView(int width, double fov) {
+    if (width <= 0) return;
+    if (cameraRays && cameraRaysWidth == width && cameraRaysFov == fov) return;
+    if (width != cameraRaysWidth) {
+        int *starts = (int*)realloc(wallStart, sizeof(int) * width);
+        if (starts) wallStart = starts;
+        int *ends = (int*)realloc(wallEnd, sizeof(int) * width);
+        if (ends) wallEnd = ends;
+        int stripCount = (width + WALL_STRIP_WIDTH - 1) / WALL_STRIP_WIDTH;
+        StripSpans *strips = (StripSpans*)realloc(stripSpans, sizeof(StripSpans) * stripCount);
+        if (strips) stripSpans = strips;
+        if (!starts || !ends || !strips) return;
+    }
+    double *table = (double*)realloc(cameraRays, sizeof(double) * width);
+    if (!table) return;
+    cameraRays = table;
+    double *angles = (double*)realloc(cameraAngles, sizeof(double) * width);
+    if (!angles) return;
+    cameraAngles = angles;
+    double planeScale = tan(fov / 2.0);
+    for (int x = 0; x < width; ++x) {
+        cameraRays[x] = (2.0 * x / width - 1.0) * planeScale;
+        cameraAngles[x] = atan(cameraRays[x]);
+    }
+    cameraRaysWidth = width;
+    cameraRaysFov = fov;
+}
+
+// Cast from the player along a world-space direction (see castRayFrom)
+RayResult castRayDir(double dirX, double dirY) {
+    return castRayFrom(playerX, playerY, dirX, dirY);
+}
+
+// Single ray at a world angle (unit direction, so distance is Euclidean)
 RayResult castRay(double angle) {
-    // Use fast approximation for sin/cos if angle is close to common values
-    double sinA, cosA;
-    
-    // Check for common angles to avoid expensive trig calculations
-    if (fabs(angle) < 0.001) {
-        sinA = 0.0;
-        cosA = 1.0;
-    } else if (fabs(angle - M_PI/2) < 0.001) {
-        sinA = 1.0;
-        cosA = 0.0;
-    } else if (fabs(angle - M_PI) < 0.001) {
-        sinA = 0.0;
-        cosA = -1.0;
-    } else if (fabs(angle - 3*M_PI/2) < 0.001) {
-        sinA = -1.0;
-        cosA = 0.0;
-    } else {
-        sinA = sin(angle);
-        cosA = cos(angle);
+    return castRayDir(cos(angle), sin(angle));
+}
+
+// Mip level for a texel-to-pixel ratio, switching levels at sqrt(2) so the
+// chosen level sits between ~0.7 and ~1.4 texels per pixel
+static int mipLevelForRatio(double texelsPerPixel) {
+    int level = 0;
+    while (level < TEX_MIP_LEVELS - 1 && texelsPerPixel > 1.41421356) {
+        texelsPerPixel *= 0.5;
+        level++;
+    }
+    return level;
+}
+
+// Screen area of the minimap, including the border pen's 1-pixel
+// overhang; 0 when the framebuffer is too small to show it
+static int minimapRect(const Framebuffer *fb, ScreenRect *rect) {
+    // Only render minimap if there's enough space
+    if (fb->width < 250 || fb->height < 250) {
+        return 0;
     }
     
-    double rayPosX = playerX;
-    double rayPosY = playerY;
-    
-    double deltaDistX = fabs(1.0 / cosA);
-    double deltaDistY = fabs(1.0 / sinA);
-    
-    int mapX = (int)rayPosX;
-    int mapY = (int)rayPosY;
-    
-    double sideDistX, sideDistY;
-    
-    int stepX, stepY;
-    int side;
+    int minimapSize = 200;
+    int minimapX = fb->width - minimapSize - 10;
+    int minimapY = 10;
     
-    if (cosA < 0) {
-        stepX = -1;
-        sideDistX = (rayPosX - mapX) * deltaDistX;
-    } else {
-        stepX = 1;
-        sideDistX = (mapX + 1.0 - rayPosX) * deltaDistX;
+    // Ensure minimap stays within bounds
+    if (minimapX < 10) minimapX = 10;
+    if (minimapY < 10) minimapY = 10;
+    if (minimapX + minimapSize > fb->width - 10) {
+        minimapX = fb->width - minimapSize - 10;
     }
-    
-    if (sinA < 0) {
-        stepY = -1;
-        sideDistY = (rayPosY - mapY) * deltaDistY;
-    } else {
-        stepY = 1;
-        sideDistY = (mapY + 1.0 - rayPosY) * deltaDistY;
+    if (minimapY + minimapSize > fb->height - 10) {
+        minimapY = fb->height - minimapSize - 10;
     }
-    
-    // DDA algorithm
-    int hit = 0;
-    while (!hit) {
-        if (sideDistX < sideDistY) {
-            sideDistX += deltaDistX;
-            mapX += stepX;
-            side = 0;
-        } else {
-            sideDistY += deltaDistY;
-            mapY += stepY;
-            side = 1;
-        }
-        
-        if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT) {
-            break;
-        }
-        
-        if (map[mapY][mapX] > 0) {
-            hit = 1;
-        }
+    rect->x0 = minimapX - 1;
+    rect->y0 = minimapY - 1;
+    rect->x1 = minimapX + minimapSize + 1;
+    rect->y1 = minimapY + minimapSize + 1;
+    return 1;
+}
+
+// Parts of [lo, hi) not covered by a HUD rectangle crossing line `at`
+// (a column when vertical, otherwise a row); returns how many parts
+static int uncoveredRanges(const FrameContext *fc, int vertical, int at, int lo, int hi,
+                           int ranges[MAX_HUD_RECTS + 1][2]) {
+    int count = 0;
+    if (lo < hi) {
+        ranges[0][0] = lo;
+        ranges[0][1] = hi;
+        count = 1;
     }
-    
-    RayResult result;
-    if (hit) {
-        if (side == 0) {
-            result.distance = (mapX - rayPosX + (1 - stepX) / 2) / cosA;
-            result.wallX = rayPosY + result.distance * sinA;
-        } else {
-            result.distance = (mapY - rayPosY + (1 - stepY) / 2) / sinA;
-            result.wallX = rayPosX + result.distance * cosA;
+    for (int r = 0; r < fc->hudCount; ++r) {
+        const ScreenRect *rect = &fc->hud[r];
+        int crossLo = vertical ? rect->x0 : rect->y0;
+        int crossHi = vertical ? rect->x1 : rect->y1;
+        if (at < crossLo || at >= crossHi) continue;
+        int cutLo = vertical ? rect->y0 : rect->x0;
+        int cutHi = vertical ? rect->y1 : rect->x1;
+        int split[MAX_HUD_RECTS + 1][2];
+        int n = 0;
+        for (int i = 0; i < count; ++i) {
+            int a = ranges[i][0], b = ranges[i][1];
+            int leftEnd = b < cutLo ? b : cutLo;
+            int rightStart = a > cutHi ? a : cutHi;
+            if (a < leftEnd && n <= MAX_HUD_RECTS) {
+                split[n][0] = a;
+                split[n][1] = leftEnd;
+                n++;
+            }
+            if (rightStart < b && n <= MAX_HUD_RECTS) {
+                split[n][0] = rightStart;
+                split[n][1] = b;
+                n++;
+            }
         }
-        
-        result.wallX -= floor(result.wallX); // Keep only fractional part
-        
-        result.wallType = map[mapY][mapX];
-        result.side = side;
-    } else {
-        result.distance = MAX_DISTANCE;
-        result.wallType = 1;
-        result.side = 0;
-        result.wallX = 0.0;
+        memcpy(ranges, split, sizeof(int) * 2 * n);
+        count = n;
     }
-    
-    return result;
+    return count;
 }
 
-void renderScene(HDC hdc) {
-    // Software renderer
-    // Fast clear sky/floor directly into backPixels
-    if (!backPixels) return;
+// Sky and textured floor for rows [y0, y1), only where the wall pass left
+// the pixel uncovered and outside the HUD
+static void renderSkyFloorRows(const FrameContext *fc, int y0, int y1) {
+    const Framebuffer *fb = fc->fb;
+    const int width = fb->width;
+    const int height = fb->height;
+    const int stride = fb->stride;
+    uint32_t *const pixels = fb->pixels;
+    const int horizon = fc->horizon;
     const uint32_t sky = colorref_to_bgra(RGB(135, 206, 235));
     const uint32_t floorCol = colorref_to_bgra(RGB(60, 60, 60));
-    int horizon = SCREEN_HEIGHT / 2 + (int)pitchOffset;
-    if (horizon < 0) horizon = 0;
-    if (horizon > SCREEN_HEIGHT) horizon = SCREEN_HEIGHT;
-    for (int y = 0; y < horizon; ++y) {
-        uint32_t *row = backPixels + y * SCREEN_WIDTH;
-        for (int x = 0; x < SCREEN_WIDTH; ++x) row[x] = sky;
-    }
-    
-    // Render textured floor
-    for (int y = horizon; y < SCREEN_HEIGHT; ++y) {
-        uint32_t *row = backPixels + y * SCREEN_WIDTH;
-        
-        // Calculate floor distance for this row
-        double rowDistance = (SCREEN_HEIGHT / 2.0) / (y - SCREEN_HEIGHT / 2.0 - pitchOffset);
-        
-        for (int x = 0; x < SCREEN_WIDTH; ++x) {
-            // Calculate floor intersection point
-            double rayAngle = playerAngle - FOV/2 + FOV * x / SCREEN_WIDTH;
-            double floorX = playerX + rowDistance * cos(rayAngle);
-            double floorY = playerY + rowDistance * sin(rayAngle);
-            
-            // Get floor texture for this position
-            int mapX = (int)floorX;
-            int mapY = (int)floorY;
-            
-            if (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 && mapY < MAP_HEIGHT) {
-                int floorTextureId = mapFloorTextures[mapY][mapX];
-                if (floorTextureId >= 0 && floorTextureId < MAX_TEXTURES && textures[floorTextureId].loaded) {
-                    // Calculate texture coordinates
-                    double texX = floorX - mapX;
-                    double texY = floorY - mapY;
-                    
-                    int texXInt = (int)(texX * TEX_WIDTH) % TEX_WIDTH;
-                    int texYInt = (int)(texY * TEX_HEIGHT) % TEX_HEIGHT;
-                    if (texXInt < 0) texXInt += TEX_WIDTH;
-                    if (texYInt < 0) texYInt += TEX_HEIGHT;
-                    
-                    COLORREF texColor = textures[floorTextureId].pixels[texYInt * TEX_WIDTH + texXInt];
-                    
-                    // Apply distance-based darkening
-                    double darkenFactor = 1.0 / (1.0 + rowDistance * 0.1);
-                    if (darkenFactor < 0.3) darkenFactor = 0.3;
-                    
-                    int r = (int)(GetRValue(texColor) * darkenFactor);
-                    int g = (int)(GetGValue(texColor) * darkenFactor);
-                    int b = (int)(GetBValue(texColor) * darkenFactor);
-                    
-                    row[x] = colorref_to_bgra(RGB(r, g, b));
+    for (int y = y0; y < y1; ++y) {
+        uint32_t *row = pixels + y * stride;
+
+        // Set up the textured floor span for rows below the horizon;
+        // rows on (or above) the true horizon get the flat floor color
+        int textured = 0;
+        FloorRow span;
+        if (y >= horizon) {
+            double rowDenom = y - height / 2.0 - pitchOffset;
+            if (rowDenom > 0.0) {
+                double rowDistance = (height / 2.0) / rowDenom;
+
+                // Floor points under the left and right screen edges, stepped across the row
+                span.posX = (float)(playerX + rowDistance * fc->rayDirLeftX);
+                span.posY = (float)(playerY + rowDistance * fc->rayDirLeftY);
+                span.stepX = (float)(rowDistance * (fc->rayDirRightX - fc->rayDirLeftX) / width);
+                span.stepY = (float)(rowDistance * (fc->rayDirRightY - fc->rayDirLeftY) / width);
+                span.level = floorLightLevel(rowDistance);
+
+                // Mip from the row's texel-to-pixel ratio: across the row the floor
+                // advances |step| per pixel, down the screen rowDistance^2/(height/2)
+                double texelsAcross = rowDistance * fc->planeWidth / width * TEX_WIDTH;
+                double texelsDown = rowDistance * rowDistance / (height / 2.0) * TEX_HEIGHT;
+                int mip = mipLevelForRatio(texelsAcross > texelsDown ? texelsAcross : texelsDown);
+                span.mipOffset = textureMipOffset(mip);
+                span.mipSize = TEX_MIP_SIZE(mip);
+                textured = 1;
+            }
+        }
+
+        // Walk the row's runs of columns whose wall span does not cover y.
+        // Wall spans contain the horizon, so above it only the span tops
+        // matter (open where wallStart > y) and below it only the bottoms
+        // (open where wallEnd <= y). Whole strips are taken or skipped
+        // when their bounds allow; columns are tested one by one otherwise.
+        const int above = y < horizon;
+        const int *edge = above ? wallStart : wallEnd;
+        int ranges[MAX_HUD_RECTS + 1][2];
+        int rangeCount = uncoveredRanges(fc, 0, y, 0, width, ranges);
+        for (int r = 0; r < rangeCount; ++r) {
+            int x = ranges[r][0];
+            const int rangeEnd = ranges[r][1];
+            while (x < rangeEnd) {
+                while (x < rangeEnd) {
+                    const StripSpans *strip = &stripSpans[x / WALL_STRIP_WIDTH];
+                    int stripOpen = above ? strip->minStart > y : strip->maxEnd <= y;
+                    int stripClosed = above ? strip->maxStart <= y : strip->minEnd > y;
+                    if (stripClosed) {
+                        x = (x / WALL_STRIP_WIDTH + 1) * WALL_STRIP_WIDTH;
+                        continue;
+                    }
+                    if (stripOpen || (edge[x] > y) == above) break;
+                    ++x;
+                }
+                if (x > rangeEnd) x = rangeEnd;
+                int runStart = x;
+                while (x < rangeEnd) {
+                    const StripSpans *strip = &stripSpans[x / WALL_STRIP_WIDTH];
+                    int stripOpen = above ? strip->minStart > y : strip->maxEnd <= y;
+                    int stripClosed = above ? strip->maxStart <= y : strip->minEnd > y;
+                    if (stripOpen) {
+                        x = (x / WALL_STRIP_WIDTH + 1) * WALL_STRIP_WIDTH;
+                        continue;
+                    }
+                    if (stripClosed || (edge[x] > y) != above) break;
+                    ++x;
+                }
+                if (x > rangeEnd) x = rangeEnd;
+                if (runStart == x) continue;
+                if (above) {
+                    for (int i = runStart; i < x; ++i) row[i] = sky;
+                } else if (textured) {
+                    rasterFloorRow(row, runStart, x, &span, &fc->floor);
                 } else {
-                    // Fallback to solid color
-                    row[x] = floorCol;
+                    for (int i = runStart; i < x; ++i) row[i] = floorCol;
                 }
-            } else {
-                row[x] = floorCol;
             }
         }
     }
+}
+
+// Raycast and draw wall columns [x0, x1), at most one strip wide
+static void renderWallColumns(const FrameContext *fc, int x0, int x1) {
+    const Framebuffer *fb = fc->fb;
+    const int width = fb->width;
+    const int height = fb->height;
+    const int stride = fb->stride;
+    uint32_t *const pixels = fb->pixels;
+    const int horizon = fc->horizon;
+
+    // Rotate the cached camera-space rays by the player's heading and cast
+    // the strip as one batch; with the ray cache on, rays whose world angle
+    // was already cast from here come from the cache
+    double dirsX[WALL_STRIP_WIDTH] = { 0 }, dirsY[WALL_STRIP_WIDTH] = { 0 };
+    double hitDistance[WALL_STRIP_WIDTH], hitWallX[WALL_STRIP_WIDTH];
+    int hitWallType[WALL_STRIP_WIDTH], hitSide[WALL_STRIP_WIDTH], hitTexture[WALL_STRIP_WIDTH];
+    int hitMapX[WALL_STRIP_WIDTH], hitMapY[WALL_STRIP_WIDTH];
+    const RayHits hits = { hitDistance, hitWallX, hitWallType, hitSide, hitTexture, hitMapX, hitMapY };
+    for (int x = x0; x < x1; x++) {
+        dirsX[x - x0] = fc->dirX - fc->dirY * cameraRays[x];
+        dirsY[x - x0] = fc->dirY + fc->dirX * cameraRays[x];
+    }
+    if (rayCacheEnabled) {
+        double rayAngles[WALL_STRIP_WIDTH];
+        for (int x = x0; x < x1; x++) rayAngles[x - x0] = fc->angle + cameraAngles[x];
+        castRaysCached(playerX, playerY, dirsX, dirsY, rayAngles, x1 - x0, &hits);
+    } else {
+        castRays(playerX, playerY, dirsX, dirsY, x1 - x0, &hits);
+    }
 
     // Walls (improved raycasting)
-    for (int x = 0; x < SCREEN_WIDTH; x++) {
-        double rayAngle = playerAngle - FOV/2 + FOV * x / SCREEN_WIDTH;
-        RayResult ray = castRay(rayAngle);
+    for (int x = x0; x < x1; x++) {
+        int i = x - x0;
+        double rayDirX = dirsX[i];
+        double rayDirY = dirsY[i];
+        int side = hitSide[i];
         
-        double perpWallDist = ray.distance;  // This is already the perpendicular distance
+        double perpWallDist = hitDistance[i];  // This is already the perpendicular distance
         
-        if (depthBuffer && x >= 0 && x < SCREEN_WIDTH) depthBuffer[x] = perpWallDist;
+        if (depthBuffer && x >= 0 && x < width) depthBuffer[x] = perpWallDist;
+
+        // Spans always contain the horizon row; an empty span sits on it
+        wallStart[x] = wallEnd[x] = horizon;
 
-        int wallHeight = (int)(SCREEN_HEIGHT / perpWallDist);
-        int start = horizon - wallHeight/2;
+        int wallHeight = (int)(height / perpWallDist);
+        if (wallHeight <= 0) continue;
+        int wallTop = horizon - wallHeight/2;
+        int start = wallTop;
         int end   = start + wallHeight;
 
         // Clamp vertical bounds
         if (start < 0) start = 0;
-        if (end > SCREEN_HEIGHT) end = SCREEN_HEIGHT;
+        if (end > height) end = height;
+        if (start >= end) continue;
+        wallStart[x] = start;
+        wallEnd[x] = end;
+
+        // Parts of the span not hidden behind the HUD
+        int segments[MAX_HUD_RECTS + 1][2];
+        int segmentCount = uncoveredRanges(fc, 1, x, start, end, segments);
+        if (segmentCount == 0) continue;
+
+        // Distance light level, resolved once per column
+        int lightLevel = wallLightLevel(perpWallDist, side);
+        double shade = lightLevelBrightness(lightLevel);
 
         if (simpleShadingMode) {
             // Flat shading per column (compute once)
-            COLORREF base = wallColors[ray.wallType];
-            double shade = 1.0 - (perpWallDist / MAX_DISTANCE) * 0.7;
-            if (ray.side == 1) shade *= 0.7;
+            COLORREF base = wallColors[hitWallType[i]];
             int r = (int)(GetRValue(base) * shade);
             int g = (int)(GetGValue(base) * shade);
             int b = (int)(GetBValue(base) * shade);
             uint32_t px = ((uint32_t)b) | (((uint32_t)g) << 8) | (((uint32_t)r) << 16) | 0xFF000000u;
-            uint32_t *col = backPixels + start * SCREEN_WIDTH + x;
-            for (int y = start; y < end; ++y) {
-                *col = px;
-                col += SCREEN_WIDTH;
+            for (int i = 0; i < segmentCount; ++i) {
+                uint32_t *col = pixels + segments[i][0] * stride + x;
+                for (int y = segments[i][0]; y < segments[i][1]; ++y) {
+                    *col = px;
+                    col += stride;
+                }
             }
         } else {
-            // Textured walls using asset textures with perspective-correct mapping
-            double wallHeightFloat = (double)(end - start);
-            
-            // Get texture ID for this wall position
-            int mapX = (int)(perpWallDist * cos(rayAngle) + playerX);
-            int mapY = (int)(perpWallDist * sin(rayAngle) + playerY);
-            if (mapX < 0) mapX = 0; if (mapX >= MAP_WIDTH) mapX = MAP_WIDTH - 1;
-            if (mapY < 0) mapY = 0; if (mapY >= MAP_HEIGHT) mapY = MAP_HEIGHT - 1;
-            int wallType = map[mapY][mapX];
-            int textureId = mapTextures[mapY][mapX];
+            // Textured walls: texture of the cell the ray actually hit
+            int wallType = hitWallType[i];
+            int textureId = hitTexture[i];
             if (textureId < 0 || textureId >= MAX_TEXTURES) textureId = 0;
-            
-            // Calculate wall intersection point properly
-            double wallX;
-            if (ray.side == 0) {
-                // Hit vertical wall
-                wallX = playerY + perpWallDist * sin(rayAngle);
-            } else {
-                // Hit horizontal wall
-                wallX = playerX + perpWallDist * cos(rayAngle);
-            }
-            wallX -= floor(wallX);
+            double wallX = hitWallX[i];
             
             // Calculate texture X coordinate
             int texX = (int)(wallX * TEX_WIDTH);
             
             // Flip texture for proper orientation
-            if ((ray.side == 0 && cos(rayAngle) > 0) || (ray.side == 1 && sin(rayAngle) < 0)) {
+            if ((side == 0 && rayDirX > 0) || (side == 1 && rayDirY < 0)) {
                 texX = TEX_WIDTH - texX - 1;
             }
             
@@ -243,84 +385,217 @@ void renderScene(HDC hdc) {
             if (texX < 0) texX = 0; 
             if (texX >= TEX_WIDTH) texX = TEX_WIDTH - 1;
             
-            // Use the same distance for texture mapping as wall height
-            double perpWallDist = ray.distance;
-            
-            // Simple direct texture mapping
-            for (int y = start; y < end; y++) {
-                // Map screen Y to texture Y directly
-                int texYInt = ((y - start) * TEX_HEIGHT) / (end - start);
-                if (texYInt < 0) texYInt = 0; if (texYInt >= TEX_HEIGHT) texYInt = TEX_HEIGHT - 1;
-                
-                COLORREF texColor;
-                if (textures[textureId].loaded) {
-                    // Choose mipmap level based on perpendicular wall distance
-                    if (perpWallDist > 6.0) {
-                        // Use mipmap for distant walls
-                        int mipTexX = texX / 2;
-                        int mipTexY = texYInt / 2;
-                        
-                        // Clamp mipmap coordinates
-                        if (mipTexX < 0) mipTexX = 0; if (mipTexX >= TEX_WIDTH/2) mipTexX = TEX_WIDTH/2 - 1;
-                        if (mipTexY < 0) mipTexY = 0; if (mipTexY >= TEX_HEIGHT/2) mipTexY = TEX_HEIGHT/2 - 1;
-                        
-                        texColor = textures[textureId].pixels_mip[mipTexY * (TEX_WIDTH/2) + mipTexX];
-                    } else {
-                        // Use full resolution texture for close walls
-                        texColor = textures[textureId].pixels[texYInt * TEX_WIDTH + texX];
+            // Acquire pairs with the stream thread's release when it swaps
+            // a decoded texture in for a placeholder
+            const Texture *tex = __atomic_load_n(&textures[textureId], __ATOMIC_ACQUIRE);
+            if (tex) {
+                textureTouch(textureId);
+                // Pick the mip level once per column from the texel-to-pixel
+                // ratio: vertically the texture spans wallHeight pixels,
+                // horizontally wallX moves by perpWallDist * |dWallX/dx|
+                // per column (larger on walls seen at a grazing angle)
+                double texelsPerPixel = (double)TEX_HEIGHT / wallHeight;
+                double wallXStep = (side == 0)
+                    ? (rayDirX != 0.0 ? fc->planeStepY - rayDirY * fc->planeStepX / rayDirX : 0.0)
+                    : (rayDirY != 0.0 ? fc->planeStepX - rayDirX * fc->planeStepY / rayDirY : 0.0);
+                double texelsAcross = fabs(wallXStep) * perpWallDist * TEX_WIDTH;
+                if (texelsAcross > texelsPerPixel) texelsPerPixel = texelsAcross;
+                int mip = mipLevelForRatio(texelsPerPixel);
+                int texHeight = TEX_MIP_SIZE(mip);
+
+                WallSpan span;
+                span.column = tex->columns + textureMipOffset(mip) + (texX >> mip) * texHeight;
+                span.texelStride = 1;
+                // 16.16 texture step; each segment starts at its own offset
+                // from the wall top, so clipping by the screen edge or the
+                // HUD samples the rows that are actually visible
+                span.texStep = ((uint32_t)texHeight << 16) / (uint32_t)wallHeight;
+                span.texMaskY = texHeight - 1;
+                span.colormap = tex->colormap[lightLevel];
+                for (int i = 0; i < segmentCount; ++i) {
+                    span.texY = (uint32_t)(segments[i][0] - wallTop) * span.texStep;
+                    rasterWallColumn(pixels + segments[i][0] * stride + x, stride,
+                                     segments[i][1] - segments[i][0], &span);
+                }
+            } else {
+                // Evicted or not loaded yet: ask for it, procedural color until then
+                textureWant(textureId);
+                uint32_t texStep = ((uint32_t)TEX_HEIGHT << 16) / (uint32_t)wallHeight;
+                for (int i = 0; i < segmentCount; ++i) {
+                    uint32_t texY = (uint32_t)(segments[i][0] - wallTop) * texStep;
+                    for (int y = segments[i][0]; y < segments[i][1]; y++, texY += texStep) {
+                        COLORREF texColor = getTextureColor(wallType, wallX, (double)(texY >> 16) / TEX_HEIGHT);
+                        int r = (int)(GetRValue(texColor) * shade);
+                        int g = (int)(GetGValue(texColor) * shade);
+                        int b = (int)(GetBValue(texColor) * shade);
+                        pixels[y * stride + x] = ((uint32_t)b) | (((uint32_t)g) << 8) | (((uint32_t)r) << 16) | 0xFF000000u;
                     }
-                } else {
-                    // Fallback to procedural color
-                    texColor = getTextureColor(wallType, wallX, (double)texYInt / TEX_HEIGHT);
                 }
-                
-                double shade = 1.0 - (perpWallDist / MAX_DISTANCE) * 0.7;
-                if (ray.side == 1) shade *= 0.7;
-                int r = (int)(GetRValue(texColor) * shade);
-                int g = (int)(GetGValue(texColor) * shade);
-                int b = (int)(GetBValue(texColor) * shade);
-                backPixels[y * SCREEN_WIDTH + x] = ((uint32_t)b) | (((uint32_t)g) << 8) | (((uint32_t)r) << 16) | 0xFF000000u;
             }
         }
     }
+}
+
+static void skyFloorBandTask(void *ctx, int band) {
+    const FrameContext *fc = (const FrameContext*)ctx;
+    int y0 = fc->rowBegin + band * FLOOR_BAND_HEIGHT;
+    int y1 = y0 + FLOOR_BAND_HEIGHT;
+    if (y1 > fc->rowEnd) y1 = fc->rowEnd;
+    renderSkyFloorRows(fc, y0, y1);
+}
+
+static void wallStripTask(void *ctx, int strip) {
+    const FrameContext *fc = (const FrameContext*)ctx;
+    int x0 = strip * WALL_STRIP_WIDTH;
+    int x1 = x0 + WALL_STRIP_WIDTH;
+    if (x1 > fc->fb->width) x1 = fc->fb->width;
+    renderWallColumns(fc, x0, x1);
+
+    StripSpans bounds = { wallStart[x0], wallStart[x0], wallEnd[x0], wallEnd[x0] };
+    for (int x = x0 + 1; x < x1; ++x) {
+        if (wallStart[x] < bounds.minStart) bounds.minStart = wallStart[x];
+        if (wallStart[x] > bounds.maxStart) bounds.maxStart = wallStart[x];
+        if (wallEnd[x] < bounds.minEnd) bounds.minEnd = wallEnd[x];
+        if (wallEnd[x] > bounds.maxEnd) bounds.maxEnd = wallEnd[x];
+    }
+    stripSpans[strip] = bounds;
+}
+
+static void renderFrame(const Framebuffer *fb) {
+    // Software renderer
+    if (!fb || !fb->pixels) return;
+    const int width = fb->width;
+    const int height = fb->height;
+    const int stride = fb->stride;
+    uint32_t *const pixels = fb->pixels;
+    int horizon = height / 2 + (int)pitchOffset;
+    if (horizon < 0) horizon = 0;
+    if (horizon > height) horizon = height;
+
+    FrameContext fc;
+    fc.fb = fb;
+    fc.horizon = horizon;
+
+    // Player heading is the only trig per frame; column rays come from the table
+    rendererSetView(width, FOV);
+    if (cameraRaysWidth != width) return;
+    double dirX = cos(playerAngle), dirY = sin(playerAngle);
+    double planeScale = tan(FOV / 2.0);
+    double planeX = -dirY * planeScale, planeY = dirX * planeScale;
+    fc.angle = playerAngle;
+    fc.dirX = dirX;
+    fc.dirY = dirY;
+    fc.rayDirLeftX = dirX - planeX;
+    fc.rayDirLeftY = dirY - planeY;
+    fc.rayDirRightX = dirX + planeX;
+    fc.rayDirRightY = dirY + planeY;
+    fc.planeStepX = 2.0 * planeX / width;
+    fc.planeStepY = 2.0 * planeY / width;
+    fc.planeWidth = 2.0 * planeScale;
+
+    // Resolve floor textures per handle once instead of per pixel, as
+    // offsets from the texture store so one 32-bit index reaches any of them
+    const uint8_t *texelBase = textureStoreBase();
+    for (int id = 0; id < MAX_TEXTURES; ++id) {
+        const Texture *tex = __atomic_load_n(&textures[id], __ATOMIC_ACQUIRE);
+        floorTextureTexels[id] = tex ? (int)(tex->texels - texelBase) : -1;
+    }
+    // Floor cells within view distance count as uses for the texture cache
+    int reach = (int)MAX_DISTANCE + 1;
+    int cellX0 = (int)playerX - reach, cellX1 = (int)playerX + reach;
+    int cellY0 = (int)playerY - reach, cellY1 = (int)playerY + reach;
+    if (cellX0 < 0) cellX0 = 0;
+    if (cellY0 < 0) cellY0 = 0;
+    if (cellX1 > map.width - 1) cellX1 = map.width - 1;
+    if (cellY1 > map.height - 1) cellY1 = map.height - 1;
+    for (int my = cellY0; my <= cellY1; ++my) {
+        for (int mx = cellX0; mx <= cellX1; ++mx) {
+            double cx = mx + 0.5 - playerX, cy = my + 0.5 - playerY;
+            if (cx * cx + cy * cy > MAX_DISTANCE * MAX_DISTANCE) continue;
+            int id = map.floorTextures[(size_t)my * map.width + mx];
+            if (floorTextureTexels[id] >= 0) textureTouch(id);
+            else textureWant(id);
+        }
+    }
+    fc.floor.texels = texelBase;
+    fc.floor.cellTextures = map.floorTextures;
+    fc.floor.textureTexels = floorTextureTexels;
+    fc.floor.colormapDelta = (int)(offsetof(Texture, colormap) - offsetof(Texture, texels));
+    fc.floor.mapW = map.width;
+    fc.floor.mapH = map.height;
+    fc.floor.fallback = colorref_to_bgra(RGB(60, 60, 60));
+
+    // HUD placement first, so the world passes can leave those pixels alone
+    static int frameCounter = 0;
+    frameCounter++;
+    int gunW = width / 5;
+    int gunH = height / 3;
+    int bob = (int)(sin(frameCounter * 0.1) * 5);
+    int gunX = width/2 - gunW/2 + (int)(sin(playerAngle) * 4);
+    int gunY = height - gunH - 10 + bob;
+    if (gunX < 0) gunX = 0;
+    if (gunY < 0) gunY = 0;
+    if (gunX + gunW > width) gunW = width - gunX;
+    if (gunY + gunH > height) gunH = height - gunY;
+
+    fc.hudCount = 0;
+    if (gunW > 0 && gunH > 0) {
+        ScreenRect gunRect = { gunX, gunY, gunX + gunW, gunY + gunH };
+        fc.hud[fc.hudCount++] = gunRect;
+    }
+    if (minimapRect(fb, &fc.hud[fc.hudCount])) fc.hudCount++;
+
+    // Walls in column strips record their spans, then sky/floor in row
+    // bands fill only what the walls left; both phases run on the worker
+    // pool when more than one render thread is enabled
+    profileBegin(PROFILE_WALLS);
+    if (rayCacheEnabled) rayCacheBeginFrame(playerX, playerY);
+    parallelFor((width + WALL_STRIP_WIDTH - 1) / WALL_STRIP_WIDTH, wallStripTask, &fc);
+    profileEnd(PROFILE_WALLS);
+
+    profileBegin(PROFILE_SKY);
+    fc.rowBegin = 0;
+    fc.rowEnd = horizon;
+    parallelFor((horizon + FLOOR_BAND_HEIGHT - 1) / FLOOR_BAND_HEIGHT, skyFloorBandTask, &fc);
+    profileEnd(PROFILE_SKY);
+
+    profileBegin(PROFILE_FLOOR);
+    fc.rowBegin = horizon;
+    fc.rowEnd = height;
+    parallelFor((height - horizon + FLOOR_BAND_HEIGHT - 1) / FLOOR_BAND_HEIGHT, skyFloorBandTask, &fc);
+    profileEnd(PROFILE_FLOOR);
 
     // Crosshair (simple lines at screen center)
-    int cx = SCREEN_WIDTH / 2;
-    int cy = SCREEN_HEIGHT / 2 + (int)pitchOffset;
+    profileBegin(PROFILE_CROSSHAIR);
+    int cx = width / 2;
+    int cy = height / 2 + (int)pitchOffset;
     int chLen = 8;
     uint32_t chCol = colorref_to_bgra(RGB(255,255,255));
     for (int dx = -chLen; dx <= chLen; ++dx) {
         int xx = cx + dx; int yy = cy;
-        if (xx >= 0 && xx < SCREEN_WIDTH && yy >= 0 && yy < SCREEN_HEIGHT) {
-            backPixels[yy * SCREEN_WIDTH + xx] = chCol;
+        if (xx >= 0 && xx < width && yy >= 0 && yy < height) {
+            pixels[yy * stride + xx] = chCol;
         }
     }
     for (int dy = -chLen; dy <= chLen; ++dy) {
         int xx = cx; int yy = cy + dy;
-        if (xx >= 0 && xx < SCREEN_WIDTH && yy >= 0 && yy < SCREEN_HEIGHT) {
-            backPixels[yy * SCREEN_WIDTH + xx] = chCol;
+        if (xx >= 0 && xx < width && yy >= 0 && yy < height) {
+            pixels[yy * stride + xx] = chCol;
         }
     }
+    profileEnd(PROFILE_CROSSHAIR);
 
     // Render enemies
-    renderEnemies();
+    profileBegin(PROFILE_SPRITES);
+    renderEnemies(fb);
+    profileEnd(PROFILE_SPRITES);
 
     // HUD gun (simple rectangle with bobbing and optional muzzle flash)
-    static int frameCounter = 0;
-    frameCounter++;
-    int gunW = SCREEN_WIDTH / 5;
-    int gunH = SCREEN_HEIGHT / 3;
-    int bob = (int)(sin(frameCounter * 0.1) * 5);
-    int gunX = SCREEN_WIDTH/2 - gunW/2 + (int)(sin(playerAngle) * 4);
-    int gunY = SCREEN_HEIGHT - gunH - 10 + bob;
-    if (gunX < 0) gunX = 0; if (gunY < 0) gunY = 0;
-    if (gunX + gunW > SCREEN_WIDTH) gunW = SCREEN_WIDTH - gunX;
-    if (gunY + gunH > SCREEN_HEIGHT) gunH = SCREEN_HEIGHT - gunY;
-
+    profileBegin(PROFILE_GUN);
     uint32_t gunDark = colorref_to_bgra(RGB(40,40,40));
     uint32_t gunLight = colorref_to_bgra(RGB(90,90,90));
     for (int y = 0; y < gunH; ++y) {
-        uint32_t *row = backPixels + (gunY + y) * SCREEN_WIDTH + gunX;
+        uint32_t *row = pixels + (gunY + y) * stride + gunX;
         for (int x2 = 0; x2 < gunW; ++x2) {
             // simple vertical gradient
             row[x2] = (y < gunH/3) ? gunLight : gunDark;
@@ -331,85 +606,113 @@ void renderScene(HDC hdc) {
     static int flashFrames = 0;
     if (flashFrames > 0) {
         flashFrames--;
-        int fx = SCREEN_WIDTH/2 - gunW/8;
+        int fx = width/2 - gunW/8;
         int fy = gunY - gunH/6;
         int fw = gunW/4;
         int fh = gunH/6;
         if (fy < 0) fy = 0;
         uint32_t flash = colorref_to_bgra(RGB(255, 240, 160));
         for (int y = 0; y < fh; ++y) {
-            int yy = fy + y; if (yy < 0 || yy >= SCREEN_HEIGHT) continue;
-            uint32_t *row = backPixels + yy * SCREEN_WIDTH;
+            int yy = fy + y; if (yy < 0 || yy >= height) continue;
+            uint32_t *row = pixels + yy * stride;
             for (int x2 = 0; x2 < fw; ++x2) {
-                int xx = fx + x2; if (xx < 0 || xx >= SCREEN_WIDTH) continue;
+                int xx = fx + x2; if (xx < 0 || xx >= width) continue;
                 row[xx] = flash;
             }
         }
     }
+    profileEnd(PROFILE_GUN);
     
     // Render minimap
-    renderMinimap(hdc);
+    profileBegin(PROFILE_MINIMAP);
+    renderMinimap(fb);
+    profileEnd(PROFILE_MINIMAP);
 }
 
-void renderMinimap(HDC hdc) {
-    // Only render minimap if there's enough space
-    if (SCREEN_WIDTH < 250 || SCREEN_HEIGHT < 250) {
-        return;
-    }
-    
-    int minimapSize = 200;
-    int minimapX = SCREEN_WIDTH - minimapSize - 10;
-    int minimapY = 10;
-    
-    // Ensure minimap stays within bounds
-    if (minimapX < 10) minimapX = 10;
-    if (minimapY < 10) minimapY = 10;
-    if (minimapX + minimapSize > SCREEN_WIDTH - 10) {
-        minimapX = SCREEN_WIDTH - minimapSize - 10;
+void renderScene(const Framebuffer *fb) {
+    profileBegin(PROFILE_RENDER);
+    // Evictions and reloads happen here, while no pass is reading textures
+    textureCacheBeginFrame();
+    renderFrame(fb);
+    profileEnd(PROFILE_RENDER);
+}
+
+// Fill a clipped rectangle [x0,x1) x [y0,y1) in the framebuffer
+static void fillRect(const Framebuffer *fb, int x0, int y0, int x1, int y1, uint32_t color) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > fb->width) x1 = fb->width;
+    if (y1 > fb->height) y1 = fb->height;
+    for (int y = y0; y < y1; ++y) {
+        uint32_t *row = fb->pixels + y * fb->stride;
+        for (int x = x0; x < x1; ++x) row[x] = color;
     }
-    if (minimapY + minimapSize > SCREEN_HEIGHT - 10) {
-        minimapY = SCREEN_HEIGHT - minimapSize - 10;
+}
+
+// Bresenham line with a square pen of the given size
+static void drawLine(const Framebuffer *fb, int x0, int y0, int x1, int y1, int pen, uint32_t color) {
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int half = pen / 2;
+    for (;;) {
+        fillRect(fb, x0 - half, y0 - half, x0 - half + pen, y0 - half + pen, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
     }
+}
+
+void renderMinimap(const Framebuffer *fb) {
+    ScreenRect area;
+    if (!minimapRect(fb, &area)) return;
+    int minimapSize = 200;
+    // Inside the 1-pixel border overhang
+    int minimapX = area.x0 + 1;
+    int minimapY = area.y0 + 1;
     
-    int cellSize = minimapSize / MAP_WIDTH;
+    // Large maps show a window of cells around the player
+    int viewCells = map.width > map.height ? map.width : map.height;
+    if (viewCells > MINIMAP_VIEW_CELLS) viewCells = MINIMAP_VIEW_CELLS;
+    int cellSize = minimapSize / viewCells;
+    int originX = (int)playerX - viewCells / 2;
+    int originY = (int)playerY - viewCells / 2;
+    if (originX > map.width - viewCells) originX = map.width - viewCells;
+    if (originY > map.height - viewCells) originY = map.height - viewCells;
+    if (originX < 0) originX = 0;
+    if (originY < 0) originY = 0;
+    int viewW = map.width - originX < viewCells ? map.width - originX : viewCells;
+    int viewH = map.height - originY < viewCells ? map.height - originY : viewCells;
     
-    // Minimap background with border
-    HBRUSH bgBrush = CreateSolidBrush(RGB(0, 0, 0));
-    RECT bgRect = {minimapX, minimapY, minimapX + minimapSize, minimapY + minimapSize};
-    FillRect(hdc, &bgRect, bgBrush);
-    DeleteObject(bgBrush);
+    // Minimap background
+    fillRect(fb, minimapX, minimapY, minimapX + minimapSize, minimapY + minimapSize, colorref_to_bgra(RGB(0, 0, 0)));
     
     // Draw border
-    HPEN borderPen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-    HPEN oldPen = SelectObject(hdc, borderPen);
-    MoveToEx(hdc, minimapX, minimapY, NULL);
-    LineTo(hdc, minimapX + minimapSize, minimapY);
-    LineTo(hdc, minimapX + minimapSize, minimapY + minimapSize);
-    LineTo(hdc, minimapX, minimapY + minimapSize);
-    LineTo(hdc, minimapX, minimapY);
-    SelectObject(hdc, oldPen);
-    DeleteObject(borderPen);
+    uint32_t borderCol = colorref_to_bgra(RGB(255, 255, 255));
+    drawLine(fb, minimapX, minimapY, minimapX + minimapSize, minimapY, 2, borderCol);
+    drawLine(fb, minimapX + minimapSize, minimapY, minimapX + minimapSize, minimapY + minimapSize, 2, borderCol);
+    drawLine(fb, minimapX + minimapSize, minimapY + minimapSize, minimapX, minimapY + minimapSize, 2, borderCol);
+    drawLine(fb, minimapX, minimapY + minimapSize, minimapX, minimapY, 2, borderCol);
     
     // Draw map cells
-    for (int y = 0; y < MAP_HEIGHT; y++) {
-        for (int x = 0; x < MAP_WIDTH; x++) {
-            if (map[y][x] > 0) {
-                RECT cell = {
+    for (int y = 0; y < viewH; y++) {
+        for (int x = 0; x < viewW; x++) {
+            int wall = mapWall(originX + x, originY + y);
+            if (wall > 0) {
+                fillRect(fb,
                     minimapX + x * cellSize,
                     minimapY + y * cellSize,
                     minimapX + (x + 1) * cellSize,
-                    minimapY + (y + 1) * cellSize
-                };
-                HBRUSH cellBrush = CreateSolidBrush(wallColors[map[y][x]]);
-                FillRect(hdc, &cell, cellBrush);
-                DeleteObject(cellBrush);
+                    minimapY + (y + 1) * cellSize,
+                    colorref_to_bgra(wallColors[wall]));
             }
         }
     }
     
     // Draw player (ensure it's within minimap bounds)
-    int playerMapX = minimapX + (int)(playerX * cellSize);
-    int playerMapY = minimapY + (int)(playerY * cellSize);
+    int playerMapX = minimapX + (int)((playerX - originX) * cellSize);
+    int playerMapY = minimapY + (int)((playerY - originY) * cellSize);
     
     // Clamp player position to minimap bounds
     if (playerMapX < minimapX) playerMapX = minimapX;
@@ -417,36 +720,22 @@ void renderMinimap(HDC hdc) {
     if (playerMapX > minimapX + minimapSize) playerMapX = minimapX + minimapSize;
     if (playerMapY > minimapY + minimapSize) playerMapY = minimapY + minimapSize;
     
-    HBRUSH playerBrush = CreateSolidBrush(RGB(255, 255, 0)); // Yellow player
-    RECT playerRect = {
-        playerMapX - 2, playerMapY - 2,
-        playerMapX + 2, playerMapY + 2
-    };
-    FillRect(hdc, &playerRect, playerBrush);
-    DeleteObject(playerBrush);
+    uint32_t playerCol = colorref_to_bgra(RGB(255, 255, 0)); // Yellow player
+    fillRect(fb, playerMapX - 2, playerMapY - 2, playerMapX + 2, playerMapY + 2, playerCol);
     
     // Draw player direction line
-    HPEN directionPen = CreatePen(PS_SOLID, 2, RGB(255, 255, 0));
-    oldPen = SelectObject(hdc, directionPen);
-    
     int dirX = playerMapX + (int)(cos(playerAngle) * 15);
     int dirY = playerMapY + (int)(sin(playerAngle) * 15);
-    
-    MoveToEx(hdc, playerMapX, playerMapY, NULL);
-    LineTo(hdc, dirX, dirY);
-    
-    SelectObject(hdc, oldPen);
-    DeleteObject(directionPen);
+    drawLine(fb, playerMapX, playerMapY, dirX, dirY, 2, playerCol);
 
     // Draw all enemies on minimap
+    uint32_t enemyCol = colorref_to_bgra(RGB(255, 0, 0));
     for (int i = 0; i < numEnemies; i++) {
-        if (enemies[i].alive) {
-            int ex = minimapX + (int)(enemies[i].x * cellSize);
-            int ey = minimapY + (int)(enemies[i].y * cellSize);
-            HBRUSH enemyBrush = CreateSolidBrush(RGB(255, 0, 0));
-            RECT enemyRect = { ex - 2, ey - 2, ex + 2, ey + 2 };
-            FillRect(hdc, &enemyRect, enemyBrush);
-            DeleteObject(enemyBrush);
+        double mx = enemies[i].x - originX, my = enemies[i].y - originY;
+        if (enemies[i].alive && mx >= 0.0 && mx < viewW && my >= 0.0 && my < viewH) {
+            int ex = minimapX + (int)(mx * cellSize);
+            int ey = minimapY + (int)(my * cellSize);
+            fillRect(fb, ex - 2, ey - 2, ex + 2, ey + 2, enemyCol);
         }
     }
 }
@@ -2,22 +2,21 @@
 #define RENDERER_H
 
 #include "raywhen.h"
-
-// Raycasting result structure
-typedef struct {
-    double distance;
-    int wallType;
-    int side; // 0 for horizontal walls, 1 for vertical walls
-    double wallX; // Where on the wall the ray hit (for texture mapping)
-} RayResult;
+#include "framebuffer.h"
+#include "raycast.h"
 
 // Performance mode: flat-shaded walls (no per-pixel texturing)
 extern int simpleShadingMode;
 extern int perfExplicitlySet; // set to 1 if -perf/--no-perf provided
 
+// Render worker threads (-threads N; 0 = one per CPU)
+extern int renderThreadCount;
+
 // Function declarations
 RayResult castRay(double angle);
-void renderScene(HDC hdc);
-void renderMinimap(HDC hdc);
+RayResult castRayDir(double dirX, double dirY);
+void rendererSetView(int width, double fov);
+void renderScene(const Framebuffer *fb);
+void renderMinimap(const Framebuffer *fb);
 
 #endif // RENDERER_H
@@ -0,0 +1,190 @@
+// Texture decode benchmark: decodes every .bmp under assets/ repeatedly and
+// reports throughput for bmpread's BGRA top-down output (what the engine
+// uses), for its default RGB output plus a separate conversion pass to
+// BGRA, and for the whole loadBMPTexture() (decode, resample, mip chain,
+// palette and colormaps).
+#include "raywhen.h"
+#include "texture.h"
+#include "bmpread.h"
+#include "profiler.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+// Global screen dimensions (unused, but the engine core expects them)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+#define MAX_BENCH_FILES 1024
+
+static char *benchFiles[MAX_BENCH_FILES];
+static int benchFileCount = 0;
+
+static int hasBmpExtension(const char *name) {
+    size_t len = strlen(name);
+    if (len < 4) return 0;
+    const char *ext = name + len - 4;
+    return ext[0] == '.' && (ext[1] | 0x20) == 'b' && (ext[2] | 0x20) == 'm' && (ext[3] | 0x20) == 'p';
+}
+
+static void addFile(const char *dir, const char *name) {
+    if (benchFileCount >= MAX_BENCH_FILES) return;
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = (char*)malloc(len);
+    if (!path) return;
+    snprintf(path, len, "%s/%s", dir, name);
+    benchFiles[benchFileCount++] = path;
+}
+
+// Collect .bmp files under dir, recursively
+static void findBitmaps(const char *dir) {
+    char sub[MAX_PATH];
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    snprintf(sub, sizeof(sub), "%s/*", dir);
+    HANDLE h = FindFirstFileA(sub, &found);
+    if (h == INVALID_HANDLE_VALUE) return;
+    do {
+        if (found.cFileName[0] == '.') continue;
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            snprintf(sub, sizeof(sub), "%s/%s", dir, found.cFileName);
+            findBitmaps(sub);
+        } else if (hasBmpExtension(found.cFileName)) {
+            addFile(dir, found.cFileName);
+        }
+    } while (FindNextFileA(h, &found));
+    FindClose(h);
+#else
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(sub, sizeof(sub), "%s/%s", dir, entry->d_name);
+        DIR *child = opendir(sub);
+        if (child) {
+            closedir(child);
+            findBitmaps(sub);
+        } else if (hasBmpExtension(entry->d_name)) {
+            addFile(dir, entry->d_name);
+        }
+    }
+    closedir(d);
+#endif
+}
+
+static int compareNames(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Default bmpread output (RGB, bottom-up, padded lines) turned into BGRA top-down
+static void convertToBGRA(const bmpread_t *bmp, uint32_t *dst) {
+    size_t lineLen = ((size_t)bmp->width * 3 + 3) & ~(size_t)3;
+    for (int y = 0; y < bmp->height; y++) {
+        const unsigned char *src = bmp->data + (size_t)(bmp->height - 1 - y) * lineLen;
+        uint32_t *row = dst + (size_t)y * bmp->width;
+        for (int x = 0; x < bmp->width; x++) {
+            row[x] = 0xFF000000u | ((uint32_t)src[x * 3] << 16) | ((uint32_t)src[x * 3 + 1] << 8) | src[x * 3 + 2];
+        }
+    }
+}
+
+typedef enum { MODE_BGRA, MODE_RGB_CONVERT, MODE_TEXTURE } BenchMode;
+
+// One pass over all files; returns pixels decoded, or -1 on a failed load
+static long long runPass(BenchMode mode, uint32_t *scratch, size_t scratchPixels) {
+    static Texture tex;
+    long long pixels = 0;
+    for (int i = 0; i < benchFileCount; i++) {
+        bmpread_t bmp;
+        if (mode == MODE_TEXTURE) {
+            if (!loadBMPTexture(&tex, benchFiles[i])) return -1;
+            pixels += TEX_WIDTH * TEX_HEIGHT;
+            continue;
+        }
+        unsigned int flags = BMPREAD_ANY_SIZE;
+        if (mode == MODE_BGRA) flags |= BMPREAD_TOP_DOWN | BMPREAD_BYTE_ALIGN | BMPREAD_BGRA;
+        if (!bmpread(benchFiles[i], flags, &bmp)) return -1;
+        if (mode == MODE_RGB_CONVERT && (size_t)bmp.width * bmp.height <= scratchPixels) {
+            convertToBGRA(&bmp, scratch);
+        }
+        pixels += (long long)bmp.width * bmp.height;
+        bmpread_free(&bmp);
+    }
+    return pixels;
+}
+
+static void runMode(const char *name, BenchMode mode, int passes, long long fileBytes,
+                    uint32_t *scratch, size_t scratchPixels) {
+    double best = 1e30, total = 0.0;
+    long long pixels = runPass(mode, scratch, scratchPixels); // warm up
+    if (pixels < 0) {
+        printf("%-22s failed to load a file\n", name);
+        return;
+    }
+    for (int p = 0; p < passes; p++) {
+        double t0 = profilerNow();
+        runPass(mode, scratch, scratchPixels);
+        double t = profilerNow() - t0;
+        total += t;
+        if (t < best) best = t;
+    }
+    printf("%-22s avg %8.3f ms  min %8.3f ms  %8.1f MB/s  %8.2f Mpix/s\n", name, total / passes, best,
+           fileBytes / (best * 1000.0), pixels / (best * 1000.0));
+}
+
+int main(int argc, char **argv) {
+    const char *dir = "assets";
+    int passes = 50;
+    for (int i = 1; i < argc; ++i) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-dir") == 0 && next) {
+            dir = next; i++;
+        } else if (strcmp(argv[i], "-passes") == 0 && next) {
+            passes = atoi(next); i++;
+            if (passes < 1) passes = 1;
+        } else {
+            printf("Usage: %s [-dir assets] [-passes n]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    findBitmaps(dir);
+    if (benchFileCount == 0) {
+        fprintf(stderr, "No .bmp files under %s\n", dir);
+        return 1;
+    }
+    qsort(benchFiles, benchFileCount, sizeof(char*), compareNames);
+
+    long long fileBytes = 0;
+    size_t maxPixels = 0;
+    for (int i = 0; i < benchFileCount; i++) {
+        FILE *f = fopen(benchFiles[i], "rb");
+        if (f) {
+            fseek(f, 0, SEEK_END);
+            fileBytes += ftell(f);
+            fclose(f);
+        }
+        bmpread_t bmp;
+        if (bmpread(benchFiles[i], BMPREAD_ANY_SIZE, &bmp)) {
+            if ((size_t)bmp.width * bmp.height > maxPixels) maxPixels = (size_t)bmp.width * bmp.height;
+            bmpread_free(&bmp);
+        }
+    }
+    uint32_t *scratch = (uint32_t*)malloc(sizeof(uint32_t) * (maxPixels ? maxPixels : 1));
+    if (!scratch) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("%d bitmaps under %s, %lld bytes, %d passes (throughput from the fastest pass)\n",
+           benchFileCount, dir, fileBytes, passes);
+    runMode("bmpread BGRA top-down", MODE_BGRA, passes, fileBytes, scratch, maxPixels);
+    runMode("bmpread RGB + convert", MODE_RGB_CONVERT, passes, fileBytes, scratch, maxPixels);
+    runMode("loadBMPTexture", MODE_TEXTURE, passes, fileBytes, scratch, maxPixels);
+
+    free(scratch);
+    for (int i = 0; i < benchFileCount; i++) free(benchFiles[i]);
+    return 0;
+}
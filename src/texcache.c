@@ -0,0 +1,113 @@
+// Texture residency manager (see texcache.h). Everything here runs on the
+// main thread between frames; the render passes only touch the per-texture
+// stamps and flags in the header.
+#include "texcache.h"
+#include "texstore.h"
+#include "texlib.h"
+
+size_t textureBudgetBytes = 0;
+uint32_t textureFrame = 0;
+uint32_t textureLastUsed[MAX_TEXTURES] = {0};
+uint8_t textureWanted[MAX_TEXTURES] = {0};
+
+static long long cacheHits = 0;
+static long long cacheMisses = 0;
+static long long cacheEvictions = 0;
+
+static int reloadIds[MAX_TEXTURES];
+
+// Slots held: loaded textures plus placeholders still on screen. The
+// budget only counts slots whose memory eviction can give back.
+static int residentCount(int count, int releasableOnly) {
+    int resident = 0;
+    for (int id = 0; id < count; id++) {
+        if (textures[id] && (!releasableOnly || textureStoreReleasable(textures[id]))) resident++;
+        if (texturePlaceholders[id]) resident++;
+    }
+    return resident;
+}
+
+// Free placeholders that the stream thread has replaced; the frame that
+// might still have been reading them has finished
+static void reclaimPlaceholders(int count) {
+    for (int id = 0; id < count; id++) {
+        Texture *placeholder = texturePlaceholders[id];
+        if (placeholder && __atomic_load_n(&textures[id], __ATOMIC_ACQUIRE) != placeholder) {
+            textureStoreRelease(placeholder);
+            texturePlaceholders[id] = NULL;
+        }
+    }
+}
+
+// Least recently used texture that the last frame did not use and that is
+// not waiting for the stream thread; -1 if there is none
+static int evictionCandidate(int count) {
+    int best = -1;
+    for (int id = 0; id < count; id++) {
+        if (!textures[id] || texturePlaceholders[id] || !textureStoreReleasable(textures[id])) continue;
+        uint32_t lastUsed = textureLastUsed[id];
+        if (lastUsed + 1 >= textureFrame) continue;
+        if (best < 0 || lastUsed < textureLastUsed[best]) best = id;
+    }
+    return best;
+}
+
+void textureCacheBeginFrame(void) {
+    int count = textureCount();
+    uint32_t lastFrame = textureFrame++;
+
+    reclaimPlaceholders(count);
+
+    // Textures the last frame used: hits if they were there, reloads if not
+    int reloadCount = 0;
+    for (int id = 0; id < count; id++) {
+        if (lastFrame > 0 && textureLastUsed[id] == lastFrame) cacheHits++;
+        if (textureWanted[id]) {
+            textureWanted[id] = 0;
+            if (!textures[id]) reloadIds[reloadCount++] = id;
+        }
+    }
+    cacheMisses += reloadCount;
+    loadTexturesInBackground(reloadIds, reloadCount);
+
+    if (textureBudgetBytes == 0) return;
+    size_t budgetSlots = textureBudgetBytes / TEX_SLOT_SIZE;
+    int resident = residentCount(count, 1);
+    // Textures in view are never evicted, even if they alone exceed the budget
+    while ((size_t)resident > budgetSlots) {
+        int id = evictionCandidate(count);
+        if (id < 0) break;
+        Texture *tex = textures[id];
+        __atomic_store_n(&textures[id], (Texture*)NULL, __ATOMIC_RELEASE);
+        textureStoreRelease(tex);
+        cacheEvictions++;
+        resident--;
+    }
+}
+
+void textureCacheGetStats(TextureCacheStats *stats) {
+    stats->hits = cacheHits;
+    stats->misses = cacheMisses;
+    stats->evictions = cacheEvictions;
+    stats->resident = residentCount(textureCount(), 0);
+    stats->residentBytes = (size_t)stats->resident * TEX_SLOT_SIZE;
+}
+
+// One line for the debug overlay; returns the length written
+int textureCacheFormat(char *buf, size_t size) {
+    TextureCacheStats stats;
+    textureCacheGetStats(&stats);
+    int len;
+    if (textureBudgetBytes > 0) {
+        len = snprintf(buf, size, "Textures: %d, %.1f/%.1f MB, hits %lld, misses %lld, evictions %lld",
+                       stats.resident, stats.residentBytes / (1024.0 * 1024.0),
+                       textureBudgetBytes / (1024.0 * 1024.0), stats.hits, stats.misses, stats.evictions);
+    } else {
+        len = snprintf(buf, size, "Textures: %d, %.1f MB, hits %lld, misses %lld, evictions %lld",
+                       stats.resident, stats.residentBytes / (1024.0 * 1024.0),
+                       stats.hits, stats.misses, stats.evictions);
+    }
+    if (len < 0) len = 0;
+    if ((size_t)len >= size) len = size > 0 ? (int)size - 1 : 0;
+    return len;
+}
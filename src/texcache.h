@@ -0,0 +1,48 @@
+#ifndef TEXCACHE_H
+#define TEXCACHE_H
+
+#include "raywhen.h"
+#include "texture.h"
+
+// Texture residency: the wall and floor passes stamp every texture they
+// use with the current frame. Between frames, textureCacheBeginFrame()
+// evicts the least recently used textures while resident texture memory
+// is over textureBudgetBytes, and reloads any texture a pass found missing:
+// a procedural placeholder at once, the decoded texture from the stream
+// thread shortly after. The passes only write per-texture stamps and flags;
+// eviction and loading never run while a frame renders. Packed textures
+// count against the budget only where the pack is mapped; a pack read
+// into memory (Windows without placeholder support) stays resident.
+
+typedef struct {
+    long long hits;       // textures found resident, per frame they were used
+    long long misses;     // textures a pass found evicted
+    long long evictions;
+    int resident;         // textures (and placeholders) holding a slot
+    size_t residentBytes;
+} TextureCacheStats;
+
+extern size_t textureBudgetBytes; // 0 = unlimited (--texture-budget-mb)
+extern uint32_t textureFrame;     // frame being rendered, from 1
+extern uint32_t textureLastUsed[MAX_TEXTURES];
+extern uint8_t textureWanted[MAX_TEXTURES];
+
+// Called from the render passes (any thread) for a texture in use / missing
+static inline void textureTouch(int textureId) {
+    if (__atomic_load_n(&textureLastUsed[textureId], __ATOMIC_RELAXED) != textureFrame) {
+        __atomic_store_n(&textureLastUsed[textureId], textureFrame, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void textureWant(int textureId) {
+    if (!__atomic_load_n(&textureWanted[textureId], __ATOMIC_RELAXED)) {
+        __atomic_store_n(&textureWanted[textureId], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Function declarations
+void textureCacheBeginFrame(void);
+void textureCacheGetStats(TextureCacheStats *stats);
+int textureCacheFormat(char *buf, size_t size);
+
+#endif // TEXCACHE_H
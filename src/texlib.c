@@ -0,0 +1,219 @@
+// Texture library (see texlib.h). Names live in one growing array indexed
+// by handle; lookups go through an open-addressing hash table of handles
+// (FNV-1a, linear probing, kept at most half full).
+#include "texlib.h"
+#include "texstore.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+const char *textureLibraryDir = "assets";
+
+// Original texture table; its order is part of the .rwm v1 format
+static const char *builtinTextures[TEXTURE_BUILTIN_COUNT] = {
+    "assets/Bricks/REDBRICKS.bmp",
+    "assets/BuildingTextures/BRICKS.bmp",
+    "assets/Industrial/METALTILE.bmp",
+    "assets/Wood/WOODA.bmp",
+    "assets/Tech/HIGHTECH.bmp",
+    "assets/Rocks/GRAYROCKS.bmp",
+    "assets/Bricks/CLAYBRICKS.bmp",
+    "assets/Industrial/CROSSWALL.bmp",
+    "assets/Urban/GRAYWALL.bmp",
+    "assets/Wood/DARKWOOD.bmp",
+    "assets/Tech/HEXAGONS.bmp",
+    "assets/Rocks/DIRT.bmp",
+    "assets/Bricks/BIGBRICKS.bmp",
+    "assets/Industrial/STORAGE.bmp",
+    "assets/Urban/PAVEMENT.bmp",
+    "assets/Wood/WOODTILE.bmp"
+};
+
+static char **names = NULL;         // by handle
+static uint32_t *nameHashes = NULL; // by handle, so growing never rehashes strings
+static int nameCount = 0;
+static int nameCapacity = 0;
+
+static int32_t *hashIndex = NULL;   // handle or -1
+static uint32_t hashMask = 0;       // table size - 1 (power of two)
+
+static int libraryReady = 0;
+
+static uint32_t hashName(const char *name) {
+    uint32_t h = 2166136261u;
+    for (; *name; name++) {
+        h = (h ^ (uint8_t)*name) * 16777619u;
+    }
+    return h;
+}
+
+// Slot in hashIndex holding name, or the empty slot where it would go
+static uint32_t probe(const char *name, uint32_t hash) {
+    uint32_t i = hash & hashMask;
+    while (hashIndex[i] >= 0) {
+        int32_t handle = hashIndex[i];
+        if (nameHashes[handle] == hash && strcmp(names[handle], name) == 0) break;
+        i = (i + 1) & hashMask;
+    }
+    return i;
+}
+
+static int growIndex(void) {
+    uint32_t size = hashIndex ? (hashMask + 1) * 2 : 256;
+    int32_t *index = (int32_t*)malloc(sizeof(int32_t) * size);
+    if (!index) return 0;
+    for (uint32_t i = 0; i < size; i++) index[i] = -1;
+    free(hashIndex);
+    hashIndex = index;
+    hashMask = size - 1;
+    for (int handle = 0; handle < nameCount; handle++) {
+        uint32_t i = nameHashes[handle] & hashMask;
+        while (hashIndex[i] >= 0) i = (i + 1) & hashMask;
+        hashIndex[i] = handle;
+    }
+    return 1;
+}
+
+static int addName(const char *name) {
+    if (nameCount >= MAX_TEXTURES) return -1;
+    if (!hashIndex || (uint32_t)(nameCount + 1) * 2 > hashMask + 1) {
+        if (!growIndex()) return -1;
+    }
+    uint32_t hash = hashName(name);
+    uint32_t slot = probe(name, hash);
+    if (hashIndex[slot] >= 0) return hashIndex[slot];
+
+    if (nameCount == nameCapacity) {
+        int capacity = nameCapacity ? nameCapacity * 2 : 64;
+        char **grownNames = (char**)realloc(names, sizeof(char*) * capacity);
+        if (!grownNames) return -1;
+        names = grownNames;
+        uint32_t *grownHashes = (uint32_t*)realloc(nameHashes, sizeof(uint32_t) * capacity);
+        if (!grownHashes) return -1;
+        nameHashes = grownHashes;
+        nameCapacity = capacity;
+    }
+    size_t len = strlen(name);
+    char *copy = (char*)malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, name, len + 1);
+
+    names[nameCount] = copy;
+    nameHashes[nameCount] = hash;
+    hashIndex[slot] = nameCount;
+    return nameCount++;
+}
+
+// Library scan results, sorted before they are registered
+typedef struct {
+    char **items;
+    int count;
+    int capacity;
+} NameList;
+
+static void listAdd(NameList *list, const char *name) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        char **grown = (char**)realloc(list->items, sizeof(char*) * capacity);
+        if (!grown) return;
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    size_t len = strlen(name);
+    char *copy = (char*)malloc(len + 1);
+    if (!copy) return;
+    memcpy(copy, name, len + 1);
+    list->items[list->count++] = copy;
+}
+
+static int hasBmpExtension(const char *name) {
+    size_t len = strlen(name);
+    if (len < 4) return 0;
+    const char *ext = name + len - 4;
+    return ext[0] == '.' && (ext[1] | 0x20) == 'b' && (ext[2] | 0x20) == 'm' && (ext[3] | 0x20) == 'p';
+}
+
+// Collect .bmp files under dir, recursively
+static void findBitmaps(NameList *list, const char *dir) {
+    char sub[MAX_PATH];
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    snprintf(sub, sizeof(sub), "%s/*", dir);
+    HANDLE h = FindFirstFileA(sub, &found);
+    if (h == INVALID_HANDLE_VALUE) return;
+    do {
+        if (found.cFileName[0] == '.') continue;
+        snprintf(sub, sizeof(sub), "%s/%s", dir, found.cFileName);
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            findBitmaps(list, sub);
+        } else if (hasBmpExtension(found.cFileName)) {
+            listAdd(list, sub);
+        }
+    } while (FindNextFileA(h, &found));
+    FindClose(h);
+#else
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(sub, sizeof(sub), "%s/%s", dir, entry->d_name);
+        DIR *child = opendir(sub);
+        if (child) {
+            closedir(child);
+            findBitmaps(list, sub);
+        } else if (hasBmpExtension(entry->d_name)) {
+            listAdd(list, sub);
+        }
+    }
+    closedir(d);
+#endif
+}
+
+static int compareNames(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Register the built-in table, then the shipped library in path order
+static void ensureLibrary(void) {
+    if (libraryReady) return;
+    libraryReady = 1;
+    for (int i = 0; i < TEXTURE_BUILTIN_COUNT; i++) {
+        addName(builtinTextures[i]);
+    }
+
+    NameList list = { NULL, 0, 0 };
+    for (int i = 0; i < texturePackCount(); i++) {
+        listAdd(&list, texturePackName(i));
+    }
+    if (textureLibraryDir) findBitmaps(&list, textureLibraryDir);
+    if (list.count > 0) qsort(list.items, list.count, sizeof(char*), compareNames);
+    for (int i = 0; i < list.count; i++) {
+        addName(list.items[i]);
+        free(list.items[i]);
+    }
+    free(list.items);
+}
+
+int textureRegister(const char *name) {
+    if (!name || !name[0]) return -1;
+    ensureLibrary();
+    return addName(name);
+}
+
+int textureFind(const char *name) {
+    if (!name) return -1;
+    ensureLibrary();
+    return hashIndex[probe(name, hashName(name))];
+}
+
+const char *textureName(int handle) {
+    ensureLibrary();
+    return (handle >= 0 && handle < nameCount) ? names[handle] : NULL;
+}
+
+int textureCount(void) {
+    ensureLibrary();
+    return nameCount;
+}
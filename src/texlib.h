@@ -0,0 +1,30 @@
+#ifndef TEXLIB_H
+#define TEXLIB_H
+
+#include "raywhen.h"
+
+// Texture library: registry of every texture the engine can use, keyed by
+// asset path. Each name gets a stable integer handle that indexes
+// textures[]; the renderer only ever sees handles. Registering a name
+// costs a few bytes; the texture itself is decoded (or found in the pack)
+// the first time a map refers to it.
+//
+// Handles 0..TEXTURE_BUILTIN_COUNT-1 are the original fixed table, in its
+// order, so existing maps keep their textures; these are the only ids a
+// map may store as bare numbers. The rest of the shipped library (the
+// texture pack index plus every .bmp under textureLibraryDir) follows,
+// sorted by path, so those handles change whenever an asset is added or
+// removed and maps must refer to them by name (the v2 TEXN section).
+
+#define TEXTURE_BUILTIN_COUNT 16
+
+// Directory scanned for the shipped library; NULL skips the scan
+extern const char *textureLibraryDir;
+
+// Function declarations
+int textureRegister(const char *name);  // handle, registered on first use; -1 if full
+int textureFind(const char *name);      // -1 if not registered
+const char *textureName(int handle);
+int textureCount(void);
+
+#endif // TEXLIB_H
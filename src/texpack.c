@@ -0,0 +1,78 @@
+// Offline texture packer: decodes every texture in the library (every .bmp
+// under the asset tree) once (resample, mip chain, palette, column copies,
+// colormaps) and writes the results as a .rwp texture pack that the engine
+// maps instead of decoding at startup. Run from the repo root or dist/ so
+// the names match the engine's texture library.
+#include "raywhen.h"
+#include "texture.h"
+#include "texstore.h"
+#include "texlib.h"
+
+// Global screen dimensions (unused, but the engine core expects them)
+int SCREEN_WIDTH = DEFAULT_SCREEN_WIDTH;
+int SCREEN_HEIGHT = DEFAULT_SCREEN_HEIGHT;
+
+int main(int argc, char **argv) {
+    const char *dir = "assets";
+    const char *outPath = DEFAULT_TEXTURE_PACK;
+    for (int i = 1; i < argc; ++i) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-dir") == 0 && next) {
+            dir = next; i++;
+        } else if (strcmp(argv[i], "-o") == 0 && next) {
+            outPath = next; i++;
+        } else {
+            printf("Usage: %s [-dir assets] [-o %s]\n", argv[0], DEFAULT_TEXTURE_PACK);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    // Never read textures back from the pack being replaced
+    texturePackPath = NULL;
+    textureLibraryDir = dir;
+    int fileCount = textureCount();
+
+    // Slots are built in ordinary memory; the writer copies them out
+    Texture **slots = (Texture**)calloc((size_t)fileCount, sizeof(Texture*));
+    const char **names = (const char**)calloc((size_t)fileCount, sizeof(char*));
+    if (!slots || !names) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    int count = 0;
+    for (int i = 0; i < fileCount; i++) {
+        Texture *tex = (Texture*)calloc(1, sizeof(Texture));
+        if (!tex) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        int quantized = texturesQuantized;
+        if (!loadBMPTexture(tex, textureName(i))) {
+            fprintf(stderr, "Skipping %s: missing or not a supported bitmap\n", textureName(i));
+            free(tex);
+            continue;
+        }
+        if (texturesQuantized != quantized) {
+            printf("Quantized %s: more than 256 colors, median cut to 256\n", textureName(i));
+        }
+        slots[count] = tex;
+        names[count] = textureName(i);
+        count++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "No .bmp files under %s\n", dir);
+        return 1;
+    }
+
+    if (!texturePackWrite(outPath, names, (const Texture *const *)slots, count)) {
+        fprintf(stderr, "Failed to write %s\n", outPath);
+        return 1;
+    }
+    printf("Packed %d textures from %s into %s (%.1f MB)\n", count, dir, outPath,
+           ((double)count * sizeof(Texture)) / (1024.0 * 1024.0));
+
+    for (int i = 0; i < count; i++) free(slots[i]);
+    free(slots);
+    free(names);
+    return 0;
+}
@@ -0,0 +1,388 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, MAP_NORESERVE, fileno()
+#endif
+
+#include "texstore.h"
+
+#ifdef _WIN32
+#include <io.h> // _get_osfhandle()
+
+// Placeholder flags (Windows 10 1803), missing from older SDK headers
+#ifndef MEM_RESERVE_PLACEHOLDER
+#define MEM_RESERVE_PLACEHOLDER 0x00040000
+#endif
+#ifndef MEM_REPLACE_PLACEHOLDER
+#define MEM_REPLACE_PLACEHOLDER 0x00004000
+#endif
+#ifndef MEM_PRESERVE_PLACEHOLDER
+#define MEM_PRESERVE_PLACEHOLDER 0x00000002
+#endif
+
+// VirtualAlloc2() and MapViewOfFile3(), looked up at run time so the game
+// still starts on Windows versions without them
+typedef PVOID (WINAPI *VirtualAlloc2Fn)(HANDLE, PVOID, SIZE_T, ULONG, ULONG, void*, ULONG);
+typedef PVOID (WINAPI *MapViewOfFile3Fn)(HANDLE, HANDLE, PVOID, ULONG64, SIZE_T, ULONG, ULONG, void*, ULONG);
+#else
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#endif
+
+const char *texturePackPath = DEFAULT_TEXTURE_PACK;
+
+// Reserved range: [pack file, if any][slots...]; slot 0 is the first pack slot
+static uint8_t *storeRegion = NULL;
+static size_t storeRegionSize = 0;
+static uint8_t *storeBase = NULL;
+static int storeSlots = 0;
+
+// Bytes at the start of the region mapped from the pack file; 0 when there
+// is no pack or it had to be read into committed memory instead
+static size_t packViewSize = 0;
+
+// Released run-time slots, reused before new ones
+static int *freeSlots = NULL;
+static int freeSlotCount = 0;
+
+// Pack index, inside the mapped pack
+static const RwpEntry *packIndex = NULL;
+static int packCount = 0;
+
+// Reserve address space for a prefix of prefixSize bytes plus every slot
+static int reserveStore(size_t prefixSize) {
+    size_t size = prefixSize + (size_t)TEXTURE_STORE_SLOTS * TEX_SLOT_SIZE;
+#ifdef _WIN32
+    uint8_t *region = (uint8_t*)VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE);
+    if (!region) return 0;
+#else
+    void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapped == MAP_FAILED) return 0;
+    uint8_t *region = (uint8_t*)mapped;
+#endif
+    storeRegion = region;
+    storeRegionSize = size;
+    storeBase = region + prefixSize;
+    storeSlots = 0;
+    return 1;
+}
+
+static void releaseStore(void) {
+    if (!storeRegion) return;
+#ifdef _WIN32
+    if (packViewSize > 0) {
+        UnmapViewOfFile(storeRegion);
+        VirtualFree(storeRegion + packViewSize, 0, MEM_RELEASE);
+    } else {
+        VirtualFree(storeRegion, 0, MEM_RELEASE);
+    }
+#else
+    munmap(storeRegion, storeRegionSize);
+#endif
+    storeRegion = storeBase = NULL;
+    storeRegionSize = 0;
+    packViewSize = 0;
+    storeSlots = 0;
+    freeSlotCount = 0;
+    packIndex = NULL;
+    packCount = 0;
+}
+
+// Back a reserved range with memory (POSIX pages appear on first touch)
+static int commitRange(uint8_t *start, size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(start, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    (void)start;
+    (void)size;
+    return 1;
+#endif
+}
+
+// Give a range's memory back; the addresses stay reserved. Anonymous pages
+// read back as zeros and pack pages are read from the file again.
+static void decommitRange(uint8_t *start, size_t size, int packed) {
+#ifdef _WIN32
+    if (!packed) {
+        VirtualFree(start, size, MEM_DECOMMIT);
+    } else if (packViewSize > 0) {
+        // Unlocking pages that are not locked drops them from the working
+        // set; the view reads them from the file again
+        VirtualUnlock(start, size);
+    }
+#else
+    (void)packed;
+    madvise(start, size, MADV_DONTNEED);
+#endif
+}
+
+// Size of a pack file: its slots, padded to RWP_FILE_ALIGN
+static uint64_t packFileSize(uint64_t dataOffset, uint64_t count) {
+    return (dataOffset + count * sizeof(Texture) + RWP_FILE_ALIGN - 1) & ~(uint64_t)(RWP_FILE_ALIGN - 1);
+}
+
+// First slot after the pack file: the ones in its padding are never used
+static int firstFreeSlot(uint64_t dataOffset, uint64_t fileSize) {
+    return (int)((fileSize - dataOffset + sizeof(Texture) - 1) / sizeof(Texture));
+}
+
+// The pack must have been written by a build with the same Texture layout
+static int packHeaderValid(const RwpHeader *h, uint64_t fileSize) {
+    return memcmp(h->magic, RWP_MAGIC, 4) == 0 &&
+           h->version == RWP_VERSION &&
+           h->slotSize == sizeof(Texture) &&
+           h->texWidth == TEX_WIDTH && h->texHeight == TEX_HEIGHT &&
+           h->mipLevels == TEX_MIP_LEVELS && h->shadeLevels == SHADE_LEVELS &&
+           h->count < TEXTURE_STORE_SLOTS &&
+           (h->dataOffset & 4095) == 0 &&
+           h->dataOffset == ((sizeof(RwpHeader) + (uint64_t)h->count * sizeof(RwpEntry) + 4095) & ~(uint64_t)4095) &&
+           fileSize == packFileSize(h->dataOffset, h->count) &&
+           firstFreeSlot(h->dataOffset, fileSize) < (int)TEXTURE_STORE_SLOTS;
+}
+
+// Names NUL-terminated and strictly ascending, slots back to back
+static int packIndexValid(const RwpEntry *index, const RwpHeader *h) {
+    for (uint32_t i = 0; i < h->count; i++) {
+        if (memchr(index[i].name, '\0', RWP_NAME_MAX) == NULL) return 0;
+        if (index[i].offset != h->dataOffset + (uint64_t)i * sizeof(Texture)) return 0;
+        if (i > 0 && strcmp(index[i - 1].name, index[i].name) >= 0) return 0;
+    }
+    return 1;
+}
+
+// Reserve the store with the pack file mapped read-only over its first
+// fileSize bytes, so texture pages are only read in when a texture is used
+static int mapPack(FILE *f, size_t prefixSize, size_t fileSize) {
+#ifdef _WIN32
+    // A fixed-address view needs a placeholder reservation: split it at
+    // the end of the file, put the view in the first part and turn the
+    // rest into ordinary reserved memory for the run-time slots. The file
+    // is padded to the allocation granularity so the split is allowed.
+    HMODULE kernelBase = GetModuleHandleA("kernelbase.dll");
+    VirtualAlloc2Fn virtualAlloc2 = NULL;
+    MapViewOfFile3Fn mapViewOfFile3 = NULL;
+    if (kernelBase) {
+        virtualAlloc2 = (VirtualAlloc2Fn)(void*)GetProcAddress(kernelBase, "VirtualAlloc2");
+        mapViewOfFile3 = (MapViewOfFile3Fn)(void*)GetProcAddress(kernelBase, "MapViewOfFile3");
+    }
+    if (!virtualAlloc2 || !mapViewOfFile3) return 0;
+    HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno(f)), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return 0;
+
+    size_t size = prefixSize + (size_t)TEXTURE_STORE_SLOTS * TEX_SLOT_SIZE;
+    uint8_t *region = (uint8_t*)virtualAlloc2(NULL, NULL, size, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER,
+                                              PAGE_NOACCESS, NULL, 0);
+    int split = region && VirtualFree(region, fileSize, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+    int viewMapped = split && mapViewOfFile3(mapping, GetCurrentProcess(), region, 0, fileSize,
+                                             MEM_REPLACE_PLACEHOLDER, PAGE_READONLY, NULL, 0) != NULL;
+    int reserved = viewMapped && virtualAlloc2(NULL, region + fileSize, size - fileSize,
+                                               MEM_RESERVE | MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, NULL, 0) != NULL;
+    CloseHandle(mapping); // the view keeps the mapping open
+    if (!reserved) {
+        if (viewMapped) UnmapViewOfFile(region);
+        else if (region) VirtualFree(region, 0, MEM_RELEASE);
+        if (split) VirtualFree(region + fileSize, 0, MEM_RELEASE);
+        return 0;
+    }
+    storeRegion = region;
+    storeRegionSize = size;
+    storeBase = region + prefixSize;
+    storeSlots = 0;
+#else
+    // Replace the start of a plain reservation with a private view
+    if (!reserveStore(prefixSize)) return 0;
+    if (mmap(storeRegion, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fileno(f), 0) == MAP_FAILED) {
+        releaseStore();
+        return 0;
+    }
+#endif
+    packViewSize = fileSize;
+    return 1;
+}
+
+// Map a texture pack at the start of the store. Only possible before the
+// first slot is handed out; returns 0 if the pack is missing or stale.
+int texturePackOpen(const char *path) {
+    if (storeRegion || !path) return 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+
+    RwpHeader header;
+    long fileSize = -1;
+    if (fseek(f, 0, SEEK_END) == 0) fileSize = ftell(f);
+    if (fileSize < (long)sizeof(header) || fseek(f, 0, SEEK_SET) != 0 ||
+        fread(&header, sizeof(header), 1, f) != 1 || !packHeaderValid(&header, (uint64_t)fileSize)) {
+        fclose(f);
+        return 0;
+    }
+
+    int ok = mapPack(f, (size_t)header.dataOffset, (size_t)fileSize);
+    if (!ok && reserveStore((size_t)header.dataOffset)) {
+        // No placeholder support (Windows before 10 1803): read the pack
+        // into the store. Its slots then cannot be dropped, so the texture
+        // cache leaves them out of the budget (textureStoreReleasable()).
+        ok = commitRange(storeRegion, (size_t)fileSize) && fseek(f, 0, SEEK_SET) == 0 &&
+             fread(storeRegion, 1, (size_t)fileSize, f) == (size_t)fileSize;
+        if (!ok) releaseStore();
+    }
+    fclose(f);
+    if (!ok) return 0;
+
+    packIndex = (const RwpEntry*)(storeRegion + sizeof(RwpHeader));
+    if (!packHeaderValid((const RwpHeader*)storeRegion, (uint64_t)fileSize) ||
+        !packIndexValid(packIndex, &header)) {
+        releaseStore();
+        return 0;
+    }
+    packCount = (int)header.count;
+    storeSlots = firstFreeSlot(header.dataOffset, (uint64_t)fileSize);
+    return 1;
+}
+
+// Set up the store on first use, from the pack when there is one
+static int ensureStore(void) {
+    if (storeRegion) return 1;
+    if (texturePackPath && texturePackOpen(texturePackPath)) return 1;
+    return reserveStore(0);
+}
+
+// Preprocessed texture for an asset path, used in place; NULL if not packed
+Texture *texturePackFind(const char *name) {
+    if (!name || !ensureStore()) return NULL;
+    int lo = 0, hi = packCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(packIndex[mid].name, name);
+        if (cmp == 0) return (Texture*)(storeBase + (size_t)mid * TEX_SLOT_SIZE);
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+int texturePackCount(void) {
+    ensureStore();
+    return packCount;
+}
+
+// Asset path of the index-th packed texture
+const char *texturePackName(int index) {
+    ensureStore();
+    return (index >= 0 && index < packCount) ? packIndex[index].name : NULL;
+}
+
+// Zeroed slot for a texture built at run time; NULL when the store is full
+Texture *textureStoreAlloc(void) {
+    if (!ensureStore()) return NULL;
+    if (freeSlotCount > 0) {
+        uint8_t *slot = storeBase + (size_t)freeSlots[freeSlotCount - 1] * TEX_SLOT_SIZE;
+        if (!commitRange(slot, TEX_SLOT_SIZE)) return NULL;
+        freeSlotCount--;
+        return (Texture*)slot;
+    }
+    if (storeSlots >= (int)TEXTURE_STORE_SLOTS) return NULL;
+    uint8_t *slot = storeBase + (size_t)storeSlots * TEX_SLOT_SIZE;
+    if (!commitRange(slot, TEX_SLOT_SIZE)) return NULL;
+    storeSlots++;
+    return (Texture*)slot;
+}
+
+// Drop a texture's memory. A run-time slot goes back to the allocator; a
+// packed texture keeps its slot and is paged in again on its next use.
+// Nothing may still be reading the texture.
+void textureStoreRelease(Texture *tex) {
+    if (!tex || !storeBase || (uint8_t*)tex < storeBase) return;
+    size_t offset = (size_t)((uint8_t*)tex - storeBase);
+    int slot = (int)(offset / TEX_SLOT_SIZE);
+    if (slot >= storeSlots || offset % TEX_SLOT_SIZE != 0) return;
+    int packed = slot < packCount;
+    if (packed && !packViewSize) return;
+    if (!packed) {
+        if (!freeSlots) {
+            freeSlots = (int*)malloc(sizeof(int) * TEXTURE_STORE_SLOTS);
+            if (!freeSlots) return;
+        }
+        freeSlots[freeSlotCount++] = slot;
+    }
+    decommitRange((uint8_t*)tex, TEX_SLOT_SIZE, packed);
+}
+
+// Whether textureStoreRelease() gives a texture's memory back: not for a
+// pack that had to be read into memory rather than mapped
+int textureStoreReleasable(const Texture *tex) {
+    if (!tex || !storeBase || packViewSize > 0 || (const uint8_t*)tex < storeBase) return 1;
+    return (size_t)((const uint8_t*)tex - storeBase) / TEX_SLOT_SIZE >= (size_t)packCount;
+}
+
+// Every texture lies within TEXTURE_STORE_SLOTS slots of this address
+const uint8_t *textureStoreBase(void) {
+    ensureStore();
+    return storeBase;
+}
+
+// Write a pack of count textures (used by the offline packer); the index
+// and the slots are sorted by name
+int texturePackWrite(const char *path, const char *const *names, const Texture *const *slots, int count) {
+    if (count < 0 || count >= (int)TEXTURE_STORE_SLOTS) return 0;
+    int *order = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+    if (!order) return 0;
+    for (int i = 0; i < count; i++) {
+        // Insertion sort by name; packs hold at most a few hundred textures
+        int j = i;
+        while (j > 0 && strcmp(names[order[j - 1]], names[i]) > 0) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    int ok = 1;
+    for (int i = 0; i < count && ok; i++) {
+        if (strlen(names[order[i]]) >= RWP_NAME_MAX) ok = 0;
+        if (i > 0 && strcmp(names[order[i - 1]], names[order[i]]) == 0) ok = 0;
+    }
+    FILE *f = ok ? fopen(path, "wb") : NULL;
+    if (!f) {
+        free(order);
+        return 0;
+    }
+
+    RwpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RWP_MAGIC, 4);
+    header.version = RWP_VERSION;
+    header.count = (uint32_t)count;
+    header.slotSize = sizeof(Texture);
+    header.texWidth = TEX_WIDTH;
+    header.texHeight = TEX_HEIGHT;
+    header.mipLevels = TEX_MIP_LEVELS;
+    header.shadeLevels = SHADE_LEVELS;
+    header.dataOffset = (sizeof(RwpHeader) + (uint64_t)count * sizeof(RwpEntry) + 4095) & ~(uint64_t)4095;
+    ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    for (int i = 0; i < count && ok; i++) {
+        RwpEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.name, names[order[i]]);
+        entry.offset = header.dataOffset + (uint64_t)i * sizeof(Texture);
+        ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+    }
+    long written = (long)(sizeof(RwpHeader) + (size_t)count * sizeof(RwpEntry));
+    while (ok && written < (long)header.dataOffset) {
+        ok = fputc(0, f) != EOF;
+        written++;
+    }
+    for (int i = 0; i < count && ok; i++) {
+        ok = fwrite(slots[order[i]], sizeof(Texture), 1, f) == 1;
+    }
+    uint64_t fileSize = packFileSize(header.dataOffset, (uint64_t)count);
+    for (uint64_t at = header.dataOffset + (uint64_t)count * sizeof(Texture); ok && at < fileSize; at++) {
+        ok = fputc(0, f) != EOF;
+    }
+
+    if (fclose(f) != 0) ok = 0;
+    free(order);
+    return ok;
+}
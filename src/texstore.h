@@ -0,0 +1,62 @@
+#ifndef TEXSTORE_H
+#define TEXSTORE_H
+
+#include "raywhen.h"
+#include "texture.h"
+
+// Texture store: one reserved address range that holds every Texture as a
+// fixed-size slot, so the floor pass can reach any texture through a 32-bit
+// offset from textureStoreBase(). When a texture pack is found it is mapped
+// read-only at the start of the store and its slots are used in place;
+// textures loaded at run time take the slots after it.
+//
+// Texture pack (.rwp) layout, little-endian:
+//   RwpHeader
+//   RwpEntry index[count], sorted by name
+//   zero padding up to dataOffset (page aligned)
+//   count Texture slots, in index order
+//   zero padding up to a multiple of RWP_FILE_ALIGN
+
+#define RWP_MAGIC "RWP\x1a"
+#define RWP_VERSION 3
+// Windows allocation granularity, where a file view has to fill a whole
+// placeholder reservation ahead of the run-time slots
+#define RWP_FILE_ALIGN 65536
+#define RWP_NAME_MAX 120
+#define DEFAULT_TEXTURE_PACK "assets/textures.rwp"
+
+// Slots reserved (address space only; pages are committed as they are used)
+#define TEXTURE_STORE_SLOTS (sizeof(void*) >= 8 ? 4096 : 256)
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t slotSize;       // sizeof(Texture) of the build that wrote it
+    uint32_t texWidth;
+    uint32_t texHeight;
+    uint32_t mipLevels;
+    uint32_t shadeLevels;
+    uint64_t dataOffset;     // first slot
+} RwpHeader;
+
+typedef struct {
+    char name[RWP_NAME_MAX]; // asset path (texture library name), NUL-terminated
+    uint64_t offset;         // file offset of the slot
+} RwpEntry;
+
+// Pack opened on first use of the store; NULL disables packs
+extern const char *texturePackPath;
+
+// Function declarations
+int texturePackOpen(const char *path);
+Texture *texturePackFind(const char *name);
+int texturePackCount(void);
+const char *texturePackName(int index);
+Texture *textureStoreAlloc(void);
+void textureStoreRelease(Texture *tex);
+int textureStoreReleasable(const Texture *tex);
+const uint8_t *textureStoreBase(void);
+int texturePackWrite(const char *path, const char *const *names, const Texture *const *slots, int count);
+
+#endif // TEXSTORE_H
@@ -0,0 +1,190 @@
+// Background texture decoder for streaming mode (see texstream.h).
+//
+// The queue is a small ring guarded by a mutex; only loadTextures() and
+// the stream thread touch it. The renderer only ever sees textures[]
+// entries, which change with one release store per finished texture.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#endif
+
+#include "texstream.h"
+#include "texstore.h"
+#include "texlib.h"
+
+int textureStreaming = 0;
+
+typedef struct {
+    int textureId;
+    const char *name;   // looked up on the main thread: the registry may grow
+    Texture *slot;      // decoded into, then published
+} StreamJob;
+
+#define STREAM_QUEUE_SIZE MAX_TEXTURES
+
+#ifdef _WIN32
+static HANDLE streamThread = NULL;
+static CRITICAL_SECTION streamLock;
+static CONDITION_VARIABLE streamWake;
+static CONDITION_VARIABLE streamIdle;
+#else
+static pthread_t streamThread;
+static pthread_mutex_t streamLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t streamWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t streamIdle = PTHREAD_COND_INITIALIZER;
+#endif
+
+static StreamJob streamQueue[STREAM_QUEUE_SIZE];
+static int queueHead = 0;       // next job to decode
+static int queueCount = 0;      // jobs waiting
+static int streamPending = 0;   // waiting plus in progress
+static int streamRunning = 0;
+static int streamStopping = 0;
+
+static void lockStream(void) {
+#ifdef _WIN32
+    EnterCriticalSection(&streamLock);
+#else
+    pthread_mutex_lock(&streamLock);
+#endif
+}
+
+static void unlockStream(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&streamLock);
+#else
+    pthread_mutex_unlock(&streamLock);
+#endif
+}
+
+static void waitStream(int idle) {
+#ifdef _WIN32
+    SleepConditionVariableCS(idle ? &streamIdle : &streamWake, &streamLock, INFINITE);
+#else
+    pthread_cond_wait(idle ? &streamIdle : &streamWake, &streamLock);
+#endif
+}
+
+static void signalStream(int idle) {
+#ifdef _WIN32
+    WakeAllConditionVariable(idle ? &streamIdle : &streamWake);
+#else
+    pthread_cond_broadcast(idle ? &streamIdle : &streamWake);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI streamMain(LPVOID arg) {
+#else
+static void *streamMain(void *arg) {
+#endif
+    (void)arg;
+    for (;;) {
+        lockStream();
+        while (!streamStopping && queueCount == 0) waitStream(0);
+        if (streamStopping) {
+            unlockStream();
+            break;
+        }
+        StreamJob job = streamQueue[queueHead];
+        queueHead = (queueHead + 1) % STREAM_QUEUE_SIZE;
+        queueCount--;
+        unlockStream();
+
+        // A file that fails to decode gets the procedural texture, as a
+        // synchronous load would; publishing it lets the placeholder go
+        if (!loadBMPTexture(job.slot, job.name)) {
+            generateTexture(job.slot, job.name, job.textureId);
+        }
+        __atomic_store_n(&textures[job.textureId], job.slot, __ATOMIC_RELEASE);
+
+        lockStream();
+        if (--streamPending == 0) signalStream(1);
+        unlockStream();
+    }
+    return 0;
+}
+
+static int startStream(void) {
+    if (streamRunning) return 1;
+#ifdef _WIN32
+    static int primitivesReady = 0;
+    if (!primitivesReady) {
+        InitializeCriticalSection(&streamLock);
+        InitializeConditionVariable(&streamWake);
+        InitializeConditionVariable(&streamIdle);
+        primitivesReady = 1;
+    }
+#endif
+    // Cleared before the thread exists, so a restart after
+    // textureStreamShutdown() cannot see the old stop request
+    lockStream();
+    streamStopping = 0;
+    unlockStream();
+#ifdef _WIN32
+    streamThread = CreateThread(NULL, 0, streamMain, NULL, 0, NULL);
+    if (!streamThread) return 0;
+#else
+    if (pthread_create(&streamThread, NULL, streamMain, NULL) != 0) return 0;
+#endif
+    streamRunning = 1;
+    return 1;
+}
+
+// Queue a texture for background decoding into slot; the caller has
+// already published a placeholder for it
+int textureStreamQueue(int textureId, Texture *slot) {
+    const char *name = textureName(textureId);
+    if (!name || !slot || !startStream()) return 0;
+    lockStream();
+    int ok = queueCount < STREAM_QUEUE_SIZE;
+    if (ok) {
+        streamQueue[(queueHead + queueCount) % STREAM_QUEUE_SIZE] = (StreamJob){ textureId, name, slot };
+        queueCount++;
+        streamPending++;
+        signalStream(0);
+    }
+    unlockStream();
+    return ok;
+}
+
+// Textures still showing their placeholder (for stats; not synchronised
+// with the render loop)
+int textureStreamPending(void) {
+    return __atomic_load_n(&streamPending, __ATOMIC_RELAXED);
+}
+
+// Block until every queued texture has been decoded and published
+void textureStreamWait(void) {
+    if (!streamRunning) return;
+    lockStream();
+    while (streamPending > 0) waitStream(1);
+    unlockStream();
+}
+
+// Stop the stream thread; textures still queued keep their placeholders
+// and the slots reserved for their decodes go back to the store
+void textureStreamShutdown(void) {
+    if (!streamRunning) return;
+    static StreamJob dropped[STREAM_QUEUE_SIZE];
+    lockStream();
+    streamStopping = 1;
+    int droppedCount = queueCount;
+    for (int i = 0; i < droppedCount; ++i) {
+        dropped[i] = streamQueue[(queueHead + i) % STREAM_QUEUE_SIZE];
+    }
+    streamPending -= queueCount;
+    queueCount = 0;
+    signalStream(0);
+    unlockStream();
+#ifdef _WIN32
+    WaitForSingleObject(streamThread, INFINITE);
+    CloseHandle(streamThread);
+#else
+    pthread_join(streamThread, NULL);
+#endif
+    // Never published, so nothing can be reading them
+    for (int i = 0; i < droppedCount; ++i) textureStoreRelease(dropped[i].slot);
+    streamRunning = 0;
+    streamPending = 0;
+}
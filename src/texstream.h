@@ -0,0 +1,23 @@
+#ifndef TEXSTREAM_H
+#define TEXSTREAM_H
+
+#include "raywhen.h"
+#include "texture.h"
+
+// Texture streaming: with textureStreaming set, loadTextures() publishes a
+// procedural placeholder for every texture that is not in the pack and
+// queues the real decode here. One background thread decodes each queued
+// texture into its own second slot and swaps it into textures[] with a
+// single atomic store, so the render loop never waits or takes a lock.
+// The texture cache frees a placeholder's slot between frames, once it has
+// been replaced (see texcache.h).
+
+extern int textureStreaming;
+
+// Function declarations
+int textureStreamQueue(int textureId, Texture *slot); // 0 if it must be decoded inline
+int textureStreamPending(void);
+void textureStreamWait(void);
+void textureStreamShutdown(void);
+
+#endif // TEXSTREAM_H
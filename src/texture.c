@@ -1,179 +1,40 @@
 #include "texture.h"
+#include "texstore.h"
+#include "texlib.h"
+#include "bmpread.h"
+#include "texstream.h"
+#include "threadpool.h"
 
-// External texture array
-Texture textures[MAX_TEXTURES] = {0};
-const char* textureFiles[] = {
-    "assets/Bricks/REDBRICKS.bmp",
-    "assets/BuildingTextures/BRICKS.bmp", 
-    "assets/Industrial/METALTILE.bmp",
-    "assets/Wood/WOODA.bmp",
-    "assets/Tech/HIGHTECH.bmp",
-    "assets/Rocks/GRAYROCKS.bmp",
-    "assets/Bricks/CLAYBRICKS.bmp",
-    "assets/Industrial/CROSSWALL.bmp",
-    "assets/Urban/GRAYWALL.bmp",
-    "assets/Wood/DARKWOOD.bmp",
-    "assets/Tech/HEXAGONS.bmp",
-    "assets/Rocks/DIRT.bmp",
-    "assets/Bricks/BIGBRICKS.bmp",
-    "assets/Industrial/STORAGE.bmp",
-    "assets/Urban/PAVEMENT.bmp",
-    "assets/Wood/WOODTILE.bmp"
-};
+// Loaded textures by handle
+Texture *textures[MAX_TEXTURES] = {0};
+
+// Placeholder published for a texture that is still decoding in the
+// background; its slot is reclaimed once the decoded texture replaces it
+Texture *texturePlaceholders[MAX_TEXTURES] = {0};
 
-// Direct BMP file reader with debug output
+// Textures whose mip chain had more than 256 colors (any thread adds)
+int texturesQuantized = 0;
+
+// Load a BMP through bmpread, straight into framebuffer BGRA, top-down,
+// and resample it (nearest neighbour) to TEX_WIDTH x TEX_HEIGHT
 int loadBMPTexture(Texture* tex, const char* filename) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        return 0; // File not found
-    }
-    
-    // Read BMP header
-    unsigned char header[54];
-    if (fread(header, 1, 54, file) != 54) {
-        fclose(file);
-        return 0;
-    }
-    
-    // Check BMP signature
-    if (header[0] != 'B' || header[1] != 'M') {
-        fclose(file);
-        return 0;
-    }
-    
-    // Get image dimensions
-    int width = *(int*)&header[18];
-    int height = *(int*)&header[22];
-    int bitsPerPixel = *(short*)&header[28];
-    
-    // Support 8-bit, 16-bit, 24-bit, and 32-bit BMPs
-    if (bitsPerPixel != 8 && bitsPerPixel != 16 && bitsPerPixel != 24 && bitsPerPixel != 32) {
-        fclose(file);
-        return 0;
-    }
-    
-    // For 8-bit BMPs, we need to read the color palette
-    unsigned char palette[256][4] = {0};
-    if (bitsPerPixel == 8) {
-        int colorsUsed = *(int*)&header[46];
-        if (colorsUsed == 0) colorsUsed = 256;
-        
-        // Read palette
-        for (int i = 0; i < colorsUsed; i++) {
-            if (fread(palette[i], 1, 4, file) != 4) {
-                fclose(file);
-                return 0;
-            }
-        }
+    bmpread_t bmp;
+    if (!bmpread(filename, BMPREAD_TOP_DOWN | BMPREAD_BYTE_ALIGN | BMPREAD_ANY_SIZE | BMPREAD_BGRA, &bmp)) {
+        return 0; // Missing, unsupported or corrupt file
     }
-    
-    // Calculate row padding
-    int bytesPerPixel = bitsPerPixel / 8;
-    int rowPadding = (4 - (width * bytesPerPixel) % 4) % 4;
-    
-    // Seek to pixel data
-    int dataOffset = *(int*)&header[10];
-    fseek(file, dataOffset, SEEK_SET);
-    
-    // Read pixel data and resize to our texture size
+
+    uint32_t pixels[TEX_MIP_TEXELS];
+    const uint32_t* src = (const uint32_t*)bmp.data;
     for (int y = 0; y < TEX_HEIGHT; y++) {
+        const uint32_t* row = src + (size_t)((y * bmp.height) / TEX_HEIGHT) * bmp.width;
         for (int x = 0; x < TEX_WIDTH; x++) {
-            // Calculate source coordinates
-            int srcX = (x * width) / TEX_WIDTH;
-            int srcY = (y * height) / TEX_HEIGHT;
-            
-            // Clamp to valid range
-            if (srcX < 0) srcX = 0;
-            if (srcX >= width) srcX = width - 1;
-            if (srcY < 0) srcY = 0;
-            if (srcY >= height) srcY = height - 1;
-            
-            // BMPs are stored bottom-up, so flip Y coordinate
-            int actualSrcY = height - 1 - srcY;
-            
-            // Calculate file position for this pixel
-            long pixelPos = dataOffset + actualSrcY * (width * bytesPerPixel + rowPadding) + srcX * bytesPerPixel;
-            fseek(file, pixelPos, SEEK_SET);
-            
-            COLORREF pixelColor;
-            
-            if (bitsPerPixel == 8) {
-                // 8-bit: read palette index
-                unsigned char paletteIndex;
-                if (fread(&paletteIndex, 1, 1, file) == 1) {
-                    unsigned char b = palette[paletteIndex][0];
-                    unsigned char g = palette[paletteIndex][1];
-                    unsigned char r = palette[paletteIndex][2];
-                    pixelColor = RGB(r, g, b);
-                } else {
-                    pixelColor = RGB(128, 128, 128);
-                }
-            } else if (bitsPerPixel == 24) {
-                // 24-bit: read BGR pixel data
-                unsigned char bgr[3];
-                if (fread(bgr, 1, 3, file) == 3) {
-                    // Convert BGR to RGB
-                    unsigned char r = bgr[2];
-                    unsigned char g = bgr[1];
-                    unsigned char b = bgr[0];
-                    pixelColor = RGB(r, g, b);
-                } else {
-                    pixelColor = RGB(128, 128, 128);
-                }
-            } else if (bitsPerPixel == 32) {
-                // 32-bit: read BGRA pixel data
-                unsigned char bgra[4];
-                if (fread(bgra, 1, 4, file) == 4) {
-                    // Convert BGRA to RGB (ignore alpha)
-                    unsigned char r = bgra[2];
-                    unsigned char g = bgra[1];
-                    unsigned char b = bgra[0];
-                    pixelColor = RGB(r, g, b);
-                } else {
-                    pixelColor = RGB(128, 128, 128);
-                }
-            } else {
-                // 16-bit: simplified handling
-                unsigned short pixel16;
-                if (fread(&pixel16, 1, 2, file) == 2) {
-                    // Extract RGB from 16-bit (5-6-5 format)
-                    unsigned char r = (pixel16 >> 11) & 0x1F;
-                    unsigned char g = (pixel16 >> 5) & 0x3F;
-                    unsigned char b = pixel16 & 0x1F;
-                    // Scale to 8-bit
-                    r = (r * 255) / 31;
-                    g = (g * 255) / 63;
-                    b = (b * 255) / 31;
-                    pixelColor = RGB(r, g, b);
-                } else {
-                    pixelColor = RGB(128, 128, 128);
-                }
-            }
-            
-            tex->pixels[y * TEX_WIDTH + x] = pixelColor;
+            pixels[y * TEX_WIDTH + x] = row[(x * bmp.width) / TEX_WIDTH];
         }
     }
-    
-    fclose(file);
-    
-    // Generate mipmap (half resolution)
-    for (int y = 0; y < TEX_HEIGHT/2; y++) {
-        for (int x = 0; x < TEX_WIDTH/2; x++) {
-            // Sample 2x2 block from original texture
-            COLORREF c00 = tex->pixels[(y*2) * TEX_WIDTH + (x*2)];
-            COLORREF c01 = tex->pixels[(y*2) * TEX_WIDTH + (x*2+1)];
-            COLORREF c10 = tex->pixels[(y*2+1) * TEX_WIDTH + (x*2)];
-            COLORREF c11 = tex->pixels[(y*2+1) * TEX_WIDTH + (x*2+1)];
-            
-            // Average the 4 pixels
-            int r = (GetRValue(c00) + GetRValue(c01) + GetRValue(c10) + GetRValue(c11)) / 4;
-            int g = (GetGValue(c00) + GetGValue(c01) + GetGValue(c10) + GetGValue(c11)) / 4;
-            int b = (GetBValue(c00) + GetBValue(c01) + GetBValue(c10) + GetBValue(c11)) / 4;
-            
-            tex->pixels_mip[y * (TEX_WIDTH/2) + x] = RGB(r, g, b);
-        }
-    }
-    
+    bmpread_free(&bmp);
+
+    buildMipChain(pixels);
+    if (buildTexturePalette(tex, pixels) > 256) __atomic_fetch_add(&texturesQuantized, 1, __ATOMIC_RELAXED);
     tex->loaded = 1;
     return 1;
 }
@@ -185,6 +46,7 @@ void generateTexture(Texture* tex, const char* filename, int textureId) {
     for (int i = 0; filename[i]; i++) {
         hash = hash * 31 + filename[i];
     }
+    uint32_t pixels[TEX_MIP_TEXELS];
     
     for (int y = 0; y < TEX_HEIGHT; y++) {
         for (int x = 0; x < TEX_WIDTH; x++) {
@@ -240,25 +102,302 @@ void generateTexture(Texture* tex, const char* filename, int textureId) {
                 case 15: // Wood tile
                     color = RGB(150,120,80) + ((x/4 + y/4) % 10);
                     break;
-                default:
-                    color = RGB(128,128,128);
+                default: // Rest of the library: a checker tinted by the name
+                    color = ((x/8 + y/8) % 2)
+                        ? RGB(96 + hash % 64, 96 + (hash >> 8) % 64, 96 + (hash >> 16) % 64)
+                        : RGB(72 + hash % 64, 72 + (hash >> 8) % 64, 72 + (hash >> 16) % 64);
             }
             
-            tex->pixels[y * TEX_WIDTH + x] = color;
+            pixels[y * TEX_WIDTH + x] = colorref_to_bgra(color);
         }
     }
+    buildMipChain(pixels);
+    buildTexturePalette(tex, pixels);
     tex->loaded = 1;
 }
 
-void loadTexture(int textureId) {
-    if (textureId < 0 || textureId >= MAX_TEXTURES) return;
-    if (textures[textureId].loaded) return;
-    
+// Start of a mip level within the per-texel arrays
+int textureMipOffset(int level) {
+    int offset = 0;
+    for (int l = 0; l < level; l++) {
+        offset += TEX_MIP_SIZE(l) * TEX_MIP_SIZE(l);
+    }
+    return offset;
+}
+
+// Fill mip levels 1..TEX_MIP_LEVELS-1 of a BGRA chain (TEX_MIP_TEXELS
+// pixels, laid out like Texture::texels) from level 0 with a 2x2 box filter
+void buildMipChain(uint32_t* pixels) {
+    for (int level = 1; level < TEX_MIP_LEVELS; level++) {
+        const uint32_t* src = pixels + textureMipOffset(level - 1);
+        uint32_t* dst = pixels + textureMipOffset(level);
+        int srcSize = TEX_MIP_SIZE(level - 1);
+        int size = TEX_MIP_SIZE(level);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                uint32_t c00 = src[(y*2) * srcSize + (x*2)];
+                uint32_t c01 = src[(y*2) * srcSize + (x*2+1)];
+                uint32_t c10 = src[(y*2+1) * srcSize + (x*2)];
+                uint32_t c11 = src[(y*2+1) * srcSize + (x*2+1)];
+
+                // Average the 4 pixels, channel by channel
+                uint32_t avg = 0;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = ((c00 >> shift) & 0xFF) + ((c01 >> shift) & 0xFF) +
+                                   ((c10 >> shift) & 0xFF) + ((c11 >> shift) & 0xFF);
+                    avg |= (sum / 4) << shift;
+                }
+                dst[y * size + x] = avg;
+            }
+        }
+    }
+}
+
+// A color of the mip chain and how many texels use it
+typedef struct {
+    uint32_t color;
+    int count;
+} ColorCount;
+
+static int compareColor(const void *a, const void *b) {
+    uint32_t x = ((const ColorCount*)a)->color, y = ((const ColorCount*)b)->color;
+    return (x > y) - (x < y);
+}
+
+// Widest of the red, green and blue ranges of colors[0..count); returns
+// the range and stores the channel's shift
+static int widestChannel(const ColorCount *colors, int count, int *shift) {
+    int best = -1;
+    for (int s = 16; s >= 0; s -= 8) {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < count; i++) {
+            int c = (int)((colors[i].color >> s) & 0xFF);
+            if (c < lo) lo = c;
+            if (c > hi) hi = c;
+        }
+        if (hi - lo > best) {
+            best = hi - lo;
+            *shift = s;
+        }
+    }
+    return best;
+}
+
+// Median cut of count distinct colors (in ascending order) into at most
+// 256 boxes: the box with the widest channel range is split along that
+// channel at its texel-weighted median until there are 256 or every box
+// holds one color. Colors are reordered box by box; box b covers
+// colors[start[b]..start[b + 1]). Returns the box count.
+static int medianCut(ColorCount *colors, ColorCount *scratch, int count, int start[257]) {
+    int boxes = 1;
+    start[0] = 0;
+    start[1] = count;
+    while (boxes < 256) {
+        int box = -1, bestRange = 0, shift = 0;
+        for (int b = 0; b < boxes; b++) {
+            int s;
+            int range = widestChannel(colors + start[b], start[b + 1] - start[b], &s);
+            if (range > bestRange) {
+                bestRange = range;
+                box = b;
+                shift = s;
+            }
+        }
+        if (box < 0) break;
+
+        // Stable counting sort of the box by that channel
+        ColorCount *first = colors + start[box];
+        int n = start[box + 1] - start[box];
+        int bucket[257] = {0};
+        for (int i = 0; i < n; i++) bucket[((first[i].color >> shift) & 0xFF) + 1]++;
+        for (int v = 0; v < 256; v++) bucket[v + 1] += bucket[v];
+        for (int i = 0; i < n; i++) scratch[bucket[(first[i].color >> shift) & 0xFF]++] = first[i];
+        memcpy(first, scratch, sizeof(ColorCount) * (size_t)n);
+
+        // First index past half the texels, leaving both halves non-empty
+        long total = 0, seen = 0;
+        for (int i = 0; i < n; i++) total += first[i].count;
+        int split = 1;
+        while (split < n - 1) {
+            seen += first[split - 1].count;
+            if (2 * seen >= total) break;
+            split++;
+        }
+        for (int b = boxes; b > box; b--) start[b + 1] = start[b];
+        start[box + 1] = start[box] + split;
+        boxes++;
+    }
+    return boxes;
+}
+
+// Index a BGRA mip chain against a palette of its own into tex, fill the
+// column-major copies and build the per-light-level colormaps. A chain
+// with at most 256 colors gets them exactly; a larger one is reduced by
+// median cut over all levels at once, so the result does not depend on
+// pixel order. Returns the number of distinct colors in the chain.
+int buildTexturePalette(Texture* tex, const uint32_t* pixels) {
+    // Distinct colors in ascending order, with their texel counts
+    ColorCount colors[TEX_MIP_TEXELS], scratch[TEX_MIP_TEXELS];
+    for (int i = 0; i < TEX_MIP_TEXELS; i++) {
+        colors[i].color = pixels[i];
+        colors[i].count = 1;
+    }
+    qsort(colors, TEX_MIP_TEXELS, sizeof(ColorCount), compareColor);
+    int distinct = 0;
+    for (int i = 0; i < TEX_MIP_TEXELS; i++) {
+        if (distinct > 0 && colors[distinct - 1].color == colors[i].color) {
+            colors[distinct - 1].count++;
+        } else {
+            colors[distinct++] = colors[i];
+        }
+    }
+
+    // Palette, and each distinct color's slot in it (kept in count)
+    uint32_t palette[256];
+    int count;
+    if (distinct <= 256) {
+        for (int i = 0; i < distinct; i++) {
+            palette[i] = colors[i].color;
+            colors[i].count = i;
+        }
+        count = distinct;
+    } else {
+        int start[257];
+        count = medianCut(colors, scratch, distinct, start);
+        for (int b = 0; b < count; b++) {
+            // Texel-weighted mean of the box
+            long sum[3] = {0, 0, 0}, texels = 0;
+            for (int i = start[b]; i < start[b + 1]; i++) {
+                for (int ch = 0; ch < 3; ch++) {
+                    sum[ch] += (long)((colors[i].color >> (ch * 8)) & 0xFF) * colors[i].count;
+                }
+                texels += colors[i].count;
+            }
+            palette[b] = 0xFF000000u;
+            for (int ch = 0; ch < 3; ch++) {
+                palette[b] |= (uint32_t)((sum[ch] + texels / 2) / texels) << (ch * 8);
+            }
+            for (int i = start[b]; i < start[b + 1]; i++) colors[i].count = b;
+        }
+        qsort(colors, (size_t)distinct, sizeof(ColorCount), compareColor);
+    }
+
+    for (int i = 0; i < TEX_MIP_TEXELS; i++) {
+        ColorCount key = { pixels[i], 0 };
+        const ColorCount *found = (const ColorCount*)bsearch(&key, colors, (size_t)distinct,
+                                                             sizeof(ColorCount), compareColor);
+        tex->texels[i] = (uint8_t)found->count;
+    }
+    // Walls walk texture columns, floors walk rows: keep both layouts
+    for (int level = 0; level < TEX_MIP_LEVELS; level++) {
+        int offset = textureMipOffset(level);
+        int size = TEX_MIP_SIZE(level);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                tex->columns[offset + x * size + y] = tex->texels[offset + y * size + x];
+            }
+        }
+    }
+    tex->paletteSize = count;
+    buildColormap(tex->colormap, palette, count);
+    return distinct;
+}
+
+// A texture that has to be decoded into its store slot
+typedef struct {
+    int textureId;
+    Texture *slot;
+    Texture *placeholder;   // streaming only: shown until slot is decoded
+} TextureJob;
+
+static void decodeTextureTask(void *ctx, int taskIndex) {
+    const TextureJob *job = (const TextureJob*)ctx + taskIndex;
     // Try to load BMP first, fallback to procedural if it fails
-    if (!loadBMPTexture(&textures[textureId], textureFiles[textureId])) {
-        // Fallback to procedural generation
-        generateTexture(&textures[textureId], textureFiles[textureId], textureId);
+    const char *name = textureName(job->textureId);
+    if (!loadBMPTexture(job->slot, name)) {
+        generateTexture(job->slot, name, job->textureId);
+    }
+}
+
+static void placeholderTask(void *ctx, int taskIndex) {
+    const TextureJob *job = (const TextureJob*)ctx + taskIndex;
+    generateTexture(job->placeholder, textureName(job->textureId), job->textureId);
+}
+
+// Scratch for loadTextureBatch(), which only runs on the main thread
+static TextureJob jobs[MAX_TEXTURES];
+static uint8_t queued[MAX_TEXTURES];
+
+// Load a batch of textures by handle (handles may repeat). Packed textures
+// are used in place; the rest get their slots up front and are decoded
+// concurrently on the worker pool. Everything is in textures[] by the time
+// this returns; in the background case that is a procedural placeholder
+// until the real decode finishes on the stream thread.
+static void loadTextureBatch(const int *textureIds, int count, int background) {
+    int jobCount = 0;
+    for (int i = 0; i < count; i++) {
+        int id = textureIds[i];
+        const char *name = textureName(id);
+        if (!name || textures[id] || queued[id]) continue;
+
+        // Preprocessed copy from the texture pack, used in place
+        Texture *tex = texturePackFind(name);
+        if (tex) {
+            textures[id] = tex;
+            continue;
+        }
+        // The store is not thread-safe: take the slots here, decode below
+        tex = textureStoreAlloc();
+        if (!tex) continue;
+        jobs[jobCount].textureId = id;
+        jobs[jobCount].slot = tex;
+        jobs[jobCount].placeholder = background ? textureStoreAlloc() : NULL;
+        jobCount++;
+        queued[id] = 1;
+    }
+    for (int j = 0; j < jobCount; j++) queued[jobs[j].textureId] = 0;
+
+    // Streaming: procedural textures cost no I/O, so show those right away
+    // and let the stream thread swap in the decoded ones. A job the stream
+    // queue cannot take is decoded here with the rest.
+    int syncCount = 0;
+    if (background) {
+        int placeholderCount = 0;
+        for (int j = 0; j < jobCount; j++) {
+            if (jobs[j].placeholder) {
+                TextureJob job = jobs[j];
+                jobs[j] = jobs[placeholderCount];
+                jobs[placeholderCount++] = job;
+            }
+        }
+        parallelFor(placeholderCount, placeholderTask, jobs);
+        for (int j = 0; j < placeholderCount; j++) {
+            texturePlaceholders[jobs[j].textureId] = jobs[j].placeholder;
+            __atomic_store_n(&textures[jobs[j].textureId], jobs[j].placeholder, __ATOMIC_RELEASE);
+            if (!textureStreamQueue(jobs[j].textureId, jobs[j].slot)) jobs[syncCount++] = jobs[j];
+        }
+        for (int j = placeholderCount; j < jobCount; j++) jobs[syncCount++] = jobs[j];
+    } else {
+        syncCount = jobCount;
     }
+
+    parallelFor(syncCount, decodeTextureTask, jobs);
+    for (int j = 0; j < syncCount; j++) {
+        __atomic_store_n(&textures[jobs[j].textureId], jobs[j].slot, __ATOMIC_RELEASE);
+    }
+}
+
+void loadTextures(const int *textureIds, int count) {
+    loadTextureBatch(textureIds, count, textureStreaming);
+}
+
+// Always show placeholders first (used to reload evicted textures)
+void loadTexturesInBackground(const int *textureIds, int count) {
+    loadTextureBatch(textureIds, count, 1);
+}
+
+void loadTexture(int textureId) {
+    loadTextures(&textureId, 1);
 }
 
 // Wall colors for different types
@@ -2,22 +2,51 @@
 #define TEXTURE_H
 
 #include "raywhen.h"
+#include "lighting.h"
 
-// Texture system
+// Mipmap chain: square power-of-two levels from TEX_WIDTH down to 1x1,
+// stored back to back (level 0 first) in each per-texel array
+#define TEX_MIP_LEVELS 7
+#define TEX_MIP_TEXELS ((TEX_WIDTH * TEX_HEIGHT * 4 - 1) / 3)
+#define TEX_MIP_SIZE(level) (TEX_WIDTH >> (level))
+
+// Per-texel arrays are padded to a multiple of 64 bytes so every array in
+// a Texture starts cache-line (and SIMD) aligned
+#define TEX_MIP_STRIDE ((TEX_MIP_TEXELS + 63) & ~63)
+
+// Bytes of texture data proper; a Texture is padded up to whole pages so
+// the slots of a mapped texture pack (see texstore.h) start page aligned
+#define TEX_DATA_BYTES (TEX_MIP_STRIDE * 2 + SHADE_LEVELS * 256 * 4 + 8)
+#define TEX_SLOT_SIZE ((TEX_DATA_BYTES + 4095) & ~4095)
+
+// Texture system. This exact layout is also the on-disk slot format of
+// .rwp packs, so changing it means rebuilding the pack. The BGRA source
+// only exists while a texture loads; slots keep the palette form.
 typedef struct {
-    COLORREF pixels[TEX_WIDTH * TEX_HEIGHT];
-    COLORREF pixels_mip[TEX_WIDTH/2 * TEX_HEIGHT/2];  // Half resolution mipmap
-    int loaded;
+    uint8_t texels[TEX_MIP_STRIDE];           // full mip chain as palette indices, row-major
+    uint8_t columns[TEX_MIP_STRIDE];          // texels transposed per level (column-major) for walls
+    uint32_t colormap[SHADE_LEVELS][256];     // palette in framebuffer BGRA, per light level
+    int32_t paletteSize;
+    int32_t loaded;
+    uint8_t padding[TEX_SLOT_SIZE - TEX_DATA_BYTES];
 } Texture;
 
 // Function declarations
 int loadBMPTexture(Texture* tex, const char* filename);
 void generateTexture(Texture* tex, const char* filename, int textureId);
 void loadTexture(int textureId);
+void loadTextures(const int *textureIds, int count);
+void loadTexturesInBackground(const int *textureIds, int count);
+void buildMipChain(uint32_t* pixels);
+int buildTexturePalette(Texture* tex, const uint32_t* pixels);
+int textureMipOffset(int level);
 COLORREF getTextureColor(int wallType, double texX, double texY);
 
-// External texture array
-extern Texture textures[MAX_TEXTURES];
-extern const char* textureFiles[];
+// Loaded textures by handle (NULL until loaded); they live in the texture store.
+// In streaming mode an entry can be swapped while a frame renders, so the
+// renderer reads them with acquire loads.
+extern Texture *textures[MAX_TEXTURES];
+extern Texture *texturePlaceholders[MAX_TEXTURES];
+extern int texturesQuantized; // loaded with more than 256 colors, median cut to 256
 
 #endif // TEXTURE_H
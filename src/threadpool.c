@@ -0,0 +1,226 @@
+// Persistent worker pool used by the renderer.
+//
+// parallelFor() splits [0, taskCount) into one contiguous range per
+// participant (the workers plus the calling thread). Each participant
+// drains its own range first and then steals from the others, so strips
+// that turn out to be expensive (close walls, busy rows) balance out.
+// Ranges are claimed with atomic fetch-add, so the hot path is lock-free;
+// the mutex/condition pair is only used to park and wake the workers
+// between jobs.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "threadpool.h"
+
+// One cache line per queue so owners and thieves don't false-share
+typedef struct {
+    volatile int next;
+    int end;
+    char pad[64 - 2 * sizeof(int)];
+} TaskQueue;
+
+#ifdef _WIN32
+typedef HANDLE PoolThread;
+static CRITICAL_SECTION poolLock;
+static CONDITION_VARIABLE poolWake;
+static CONDITION_VARIABLE poolDone;
+#else
+typedef pthread_t PoolThread;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t poolDone = PTHREAD_COND_INITIALIZER;
+#endif
+
+static PoolThread workers[MAX_RENDER_THREADS];
+static TaskQueue queues[MAX_RENDER_THREADS];
+static int poolSize = 1;        // participants, including the caller
+static int jobGeneration = 0;   // bumped for every parallelFor()
+static int workersBusy = 0;     // workers still running the current job
+static int poolStopping = 0;
+static ParallelTaskFn jobFn = NULL;
+static void *jobCtx = NULL;
+
+static void lockPool(void) {
+#ifdef _WIN32
+    EnterCriticalSection(&poolLock);
+#else
+    pthread_mutex_lock(&poolLock);
+#endif
+}
+
+static void unlockPool(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&poolLock);
+#else
+    pthread_mutex_unlock(&poolLock);
+#endif
+}
+
+static void waitWake(void) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&poolWake, &poolLock, INFINITE);
+#else
+    pthread_cond_wait(&poolWake, &poolLock);
+#endif
+}
+
+static void waitDone(void) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&poolDone, &poolLock, INFINITE);
+#else
+    pthread_cond_wait(&poolDone, &poolLock);
+#endif
+}
+
+static void signalWake(void) {
+#ifdef _WIN32
+    WakeAllConditionVariable(&poolWake);
+#else
+    pthread_cond_broadcast(&poolWake);
+#endif
+}
+
+static void signalDone(void) {
+#ifdef _WIN32
+    WakeConditionVariable(&poolDone);
+#else
+    pthread_cond_signal(&poolDone);
+#endif
+}
+
+// Claim the next task from queue q, or -1 if it is drained
+static int claimTask(int q) {
+    if (queues[q].next >= queues[q].end) return -1;
+    int t = __atomic_fetch_add(&queues[q].next, 1, __ATOMIC_RELAXED);
+    return (t < queues[q].end) ? t : -1;
+}
+
+// Run own queue to completion, then steal from the others
+static void runTasks(int self) {
+    int t;
+    while ((t = claimTask(self)) >= 0) jobFn(jobCtx, t);
+    for (int i = 1; i < poolSize; ++i) {
+        int victim = (self + i) % poolSize;
+        while ((t = claimTask(victim)) >= 0) jobFn(jobCtx, t);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI workerMain(LPVOID arg) {
+#else
+static void *workerMain(void *arg) {
+#endif
+    int self = (int)(intptr_t)arg;
+    int seen = 0;
+    for (;;) {
+        lockPool();
+        while (!poolStopping && jobGeneration == seen) waitWake();
+        if (poolStopping) {
+            unlockPool();
+            break;
+        }
+        seen = jobGeneration;
+        unlockPool();
+
+        runTasks(self);
+
+        lockPool();
+        if (--workersBusy == 0) signalDone();
+        unlockPool();
+    }
+    return 0;
+}
+
+int cpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+int threadPoolInit(int numThreads) {
+    threadPoolShutdown();
+    if (numThreads <= 0) numThreads = cpuCount();
+    if (numThreads > MAX_RENDER_THREADS) numThreads = MAX_RENDER_THREADS;
+
+#ifdef _WIN32
+    static int primitivesReady = 0;
+    if (!primitivesReady) {
+        InitializeCriticalSection(&poolLock);
+        InitializeConditionVariable(&poolWake);
+        InitializeConditionVariable(&poolDone);
+        primitivesReady = 1;
+    }
+#endif
+
+    poolStopping = 0;
+    poolSize = 1;
+    for (int i = 1; i < numThreads; ++i) {
+#ifdef _WIN32
+        workers[i] = CreateThread(NULL, 0, workerMain, (LPVOID)(intptr_t)i, 0, NULL);
+        if (!workers[i]) break;
+#else
+        if (pthread_create(&workers[i], NULL, workerMain, (void*)(intptr_t)i) != 0) break;
+#endif
+        poolSize++;
+    }
+    return poolSize;
+}
+
+void threadPoolShutdown(void) {
+    if (poolSize <= 1) return;
+    lockPool();
+    poolStopping = 1;
+    signalWake();
+    unlockPool();
+    for (int i = 1; i < poolSize; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(workers[i], INFINITE);
+        CloseHandle(workers[i]);
+#else
+        pthread_join(workers[i], NULL);
+#endif
+    }
+    poolSize = 1;
+    jobGeneration = 0;
+}
+
+int threadPoolSize(void) {
+    return poolSize;
+}
+
+void parallelFor(int taskCount, ParallelTaskFn fn, void *ctx) {
+    if (taskCount <= 0) return;
+    if (poolSize <= 1 || taskCount == 1) {
+        for (int t = 0; t < taskCount; ++t) fn(ctx, t);
+        return;
+    }
+
+    // Deal the tasks out as contiguous ranges, one per participant
+    int participants = poolSize;
+    for (int i = 0; i < participants; ++i) {
+        queues[i].next = (int)((long long)taskCount * i / participants);
+        queues[i].end = (int)((long long)taskCount * (i + 1) / participants);
+    }
+
+    lockPool();
+    jobFn = fn;
+    jobCtx = ctx;
+    workersBusy = participants - 1;
+    jobGeneration++;
+    signalWake();
+    unlockPool();
+
+    runTasks(0);
+
+    lockPool();
+    while (workersBusy > 0) waitDone();
+    unlockPool();
+}
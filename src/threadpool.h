@@ -0,0 +1,18 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "raywhen.h"
+
+#define MAX_RENDER_THREADS 64
+
+// Task callback: invoked once for each index in [0, taskCount)
+typedef void (*ParallelTaskFn)(void *ctx, int taskIndex);
+
+// Function declarations
+int threadPoolInit(int numThreads); // 0 = one thread per CPU; counts the calling thread
+void threadPoolShutdown(void);
+int threadPoolSize(void);
+int cpuCount(void);
+void parallelFor(int taskCount, ParallelTaskFn fn, void *ctx);
+
+#endif // THREADPOOL_H
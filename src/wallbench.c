@@ -0,0 +1,246 @@
+// Wall pass micro-benchmark: draws the same set of textured wall columns
+// from the row-major texels and from the column-major copies, and reports
+// time per pass plus L1 data cache read misses (Linux perf counters, where
+// the kernel allows them) for each layout. It also counts how many distinct
+// 64-byte texture lines each column walks, which does not depend on the
+// counters being available.
+#ifndef _WIN32
+#define _GNU_SOURCE // syscall() for perf_event_open
+#endif
+
+#include "raywhen.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "texlib.h"
+#include "raster.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Global screen dimensions (fixed for the whole run)
+int SCREEN_WIDTH = 3840;
+int SCREEN_HEIGHT = 2160;
+
+// One run of adjacent screen columns showing the same wall face
+typedef struct {
+    int x0, x1;
+    int textureId;
+    int wallHeight;    // projected height at x0
+    int heightStep;    // change per column (perspective)
+    double texX0;      // texture coordinate at x0, in texels
+    double texXStep;   // texels per screen column
+} WallRun;
+
+static double nowMs(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+// L1D read-miss counter for this thread; -1 if unavailable
+static int openMissCounter(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void startCounter(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#else
+    (void)fd;
+#endif
+}
+
+static long long stopCounter(int fd) {
+#ifdef __linux__
+    long long value = -1;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) return -1;
+    return value;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+// Small deterministic generator so both layouts see the same scene
+static unsigned int benchRand(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 16) & 0x7FFF;
+}
+
+static int buildRuns(WallRun *runs, int maxRuns, int width, int height) {
+    unsigned int seed = 1234;
+    int count = 0;
+    int x = 0;
+    while (x < width && count < maxRuns) {
+        WallRun *r = &runs[count++];
+        int len = 8 + (int)(benchRand(&seed) % 200);
+        r->x0 = x;
+        r->x1 = (x + len < width) ? x + len : width;
+        r->textureId = (int)(benchRand(&seed) % TEXTURE_BUILTIN_COUNT);
+        // From far walls (a few pixels tall) up to walls taller than the screen
+        r->wallHeight = height / 16 + (int)(benchRand(&seed) % (unsigned int)(height * 2));
+        r->heightStep = (int)(benchRand(&seed) % 5) - 2;
+        r->texX0 = (double)(benchRand(&seed) % TEX_WIDTH);
+        r->texXStep = (double)TEX_WIDTH / (r->wallHeight > 0 ? r->wallHeight : 1);
+        x = r->x1;
+    }
+    return count;
+}
+
+// Draw every run once; columnMajor picks the texture layout
+static void drawWalls(const Framebuffer *fb, const WallRun *runs, int runCount, int columnMajor) {
+    const int height = fb->height;
+    for (int r = 0; r < runCount; ++r) {
+        const WallRun *run = &runs[r];
+        const Texture *tex = textures[run->textureId];
+        for (int x = run->x0; x < run->x1; ++x) {
+            int wallHeight = run->wallHeight + (x - run->x0) * run->heightStep;
+            if (wallHeight < 1) wallHeight = 1;
+            int wallTop = (height - wallHeight) / 2;
+            int start = wallTop < 0 ? 0 : wallTop;
+            int end = wallTop + wallHeight > height ? height : wallTop + wallHeight;
+            int texX = (int)(run->texX0 + (x - run->x0) * run->texXStep) & (TEX_WIDTH - 1);
+
+            WallSpan span;
+            if (columnMajor) {
+                span.column = tex->columns + texX * TEX_HEIGHT;
+                span.texelStride = 1;
+            } else {
+                span.column = tex->texels + texX;
+                span.texelStride = TEX_WIDTH;
+            }
+            span.colormap = tex->colormap[(x >> 4) % SHADE_LEVELS];
+            span.texMaskY = TEX_HEIGHT - 1;
+            span.texStep = ((uint32_t)TEX_HEIGHT << 16) / (uint32_t)wallHeight;
+            span.texY = (uint32_t)(start - wallTop) * span.texStep;
+            rasterWallColumn(fb->pixels + start * fb->stride + x, fb->stride, end - start, &span);
+        }
+    }
+}
+
+// Texture cache lines entered while sampling every column (a new line is
+// counted whenever consecutive samples land in different lines)
+static long long countTextureLines(const Framebuffer *fb, const WallRun *runs, int runCount, int columnMajor) {
+    const int height = fb->height;
+    long long lines = 0;
+    for (int r = 0; r < runCount; ++r) {
+        const WallRun *run = &runs[r];
+        const Texture *tex = textures[run->textureId];
+        for (int x = run->x0; x < run->x1; ++x) {
+            int wallHeight = run->wallHeight + (x - run->x0) * run->heightStep;
+            if (wallHeight < 1) wallHeight = 1;
+            int wallTop = (height - wallHeight) / 2;
+            int start = wallTop < 0 ? 0 : wallTop;
+            int end = wallTop + wallHeight > height ? height : wallTop + wallHeight;
+            int texX = (int)(run->texX0 + (x - run->x0) * run->texXStep) & (TEX_WIDTH - 1);
+            uint32_t texStep = ((uint32_t)TEX_HEIGHT << 16) / (uint32_t)wallHeight;
+            uint32_t texY = (uint32_t)(start - wallTop) * texStep;
+            uintptr_t lastLine = 0;
+            for (int y = start; y < end; ++y, texY += texStep) {
+                int ty = (int)(texY >> 16) & (TEX_HEIGHT - 1);
+                const uint8_t *texel = columnMajor ? tex->columns + texX * TEX_HEIGHT + ty
+                                                   : tex->texels + ty * TEX_WIDTH + texX;
+                uintptr_t line = (uintptr_t)texel >> 6;
+                if (line != lastLine) {
+                    lines++;
+                    lastLine = line;
+                }
+            }
+        }
+    }
+    return lines;
+}
+
+static void runLayout(const char *name, const Framebuffer *fb, const WallRun *runs, int runCount,
+                      int columnMajor, int passes, int missFd) {
+    drawWalls(fb, runs, runCount, columnMajor); // warm up
+    double best = 1e30, total = 0.0;
+    long long misses = 0;
+    for (int p = 0; p < passes; ++p) {
+        startCounter(missFd);
+        double t0 = nowMs();
+        drawWalls(fb, runs, runCount, columnMajor);
+        double t = nowMs() - t0;
+        long long m = stopCounter(missFd);
+        if (m < 0) misses = -1;
+        else if (misses >= 0) misses += m;
+        total += t;
+        if (t < best) best = t;
+    }
+    printf("%-13s avg %7.3f ms  min %7.3f ms  texture lines/pass %lld", name, total / passes, best,
+           countTextureLines(fb, runs, runCount, columnMajor));
+    if (misses >= 0) printf("  L1D read misses/pass %lld", misses / passes);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    int passes = 50;
+    for (int i = 1; i < argc; ++i) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-w") == 0 && next) {
+            int w = atoi(next); i++;
+            if (w > 0 && w <= 8192) SCREEN_WIDTH = w;
+        } else if (strcmp(argv[i], "-h") == 0 && next) {
+            int h = atoi(next); i++;
+            if (h > 0 && h <= 8192) SCREEN_HEIGHT = h;
+        } else if (strcmp(argv[i], "-passes") == 0 && next) {
+            passes = atoi(next); i++;
+            if (passes < 1) passes = 1;
+        } else {
+            printf("Usage: %s [-w width] [-h height] [-passes n]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    rasterInit();
+    for (int i = 0; i < TEXTURE_BUILTIN_COUNT; ++i) loadTexture(i);
+
+    Framebuffer fb;
+    if (!framebufferCreate(&fb, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        fprintf(stderr, "Failed to allocate %dx%d framebuffer\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        return 1;
+    }
+    static WallRun runs[8192];
+    int runCount = buildRuns(runs, 8192, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    int missFd = openMissCounter();
+    printf("Resolution: %dx%d, %d wall runs, %d passes\n", SCREEN_WIDTH, SCREEN_HEIGHT, runCount, passes);
+    if (missFd < 0) printf("Cache counters unavailable (perf_event_open failed); timing only\n");
+    runLayout("row-major", &fb, runs, runCount, 0, passes, missFd);
+    runLayout("column-major", &fb, runs, runCount, 1, passes, missFd);
+
+#ifdef __linux__
+    if (missFd >= 0) close(missFd);
+#endif
+    framebufferDestroy(&fb);
+    return 0;
+}
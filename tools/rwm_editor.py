@@ -7,10 +7,11 @@ A comprehensive Python map editor for RayWhen RWM files using tkinter.
 import tkinter as tk
 from tkinter import ttk, filedialog, messagebox, colorchooser
 import os
-import struct
 from pathlib import Path
 import json
 
+import rwm_format
+
 class RWMEditor:
     def __init__(self, root):
         self.root = root
@@ -34,6 +35,7 @@ class RWMEditor:
         self.map_name = "Untitled Map"
         self.map_description = "A RayWhen map"
         self.map_author = "Unknown"
+        self.map_textures = None  # texture names from a v2 file; None = built-in list
         
         self.setup_ui()
         self.load_default_map()
@@ -613,6 +615,7 @@ Floor: {len([t for t in floor_texture_counts.values() if t > 0])}"""
             self.map_name = "Untitled Map"
             self.map_description = "A RayWhen map"
             self.map_author = "Unknown"
+            self.map_textures = None
             self.current_file = None
             
             self.name_entry.delete(0, tk.END)
@@ -669,86 +672,37 @@ Floor: {len([t for t in floor_texture_counts.values() if t > 0])}"""
                 messagebox.showerror("Error", f"Failed to save map: {str(e)}")
                 
     def load_rwm_file(self, file_path):
-        """Load an RWM file"""
-        with open(file_path, 'rb') as f:
-            # Read header
-            magic = f.read(3)
-            if magic != b'RWM':
-                raise ValueError("Invalid RWM file")
-                
-            version = struct.unpack('<B', f.read(1))[0]
-            if version != 1:
-                raise ValueError(f"Unsupported RWM version: {version}")
-                
-            width = struct.unpack('<H', f.read(2))[0]
-            height = struct.unpack('<H', f.read(2))[0]
-            
-            if width != 16 or height != 16:
-                raise ValueError(f"Unsupported map size: {width}x{height}")
-                
-            # Read metadata
-            name_len = struct.unpack('<B', f.read(1))[0]
-            self.map_name = f.read(name_len).decode('utf-8', errors='ignore') if name_len > 0 else "Untitled Map"
-            
-            desc_len = struct.unpack('<B', f.read(1))[0]
-            self.map_description = f.read(desc_len).decode('utf-8', errors='ignore') if desc_len > 0 else "A RayWhen map"
-            
-            author_len = struct.unpack('<B', f.read(1))[0]
-            self.map_author = f.read(author_len).decode('utf-8', errors='ignore') if author_len > 0 else "Unknown"
-            
-            # Update UI
-            self.name_entry.delete(0, tk.END)
-            self.name_entry.insert(0, self.map_name)
-            self.desc_text.delete(1.0, tk.END)
-            self.desc_text.insert(1.0, self.map_description)
-            self.author_entry.delete(0, tk.END)
-            self.author_entry.insert(0, self.map_author)
+        """Load an RWM file (version 1 or 2)"""
+        rwm = rwm_format.read_rwm(file_path)
+        if rwm['width'] != 16 or rwm['height'] != 16:
+            raise ValueError(f"Unsupported map size: {rwm['width']}x{rwm['height']}")
             
-            # Read map data
-            for y in range(16):
-                for x in range(16):
-                    wall_type = struct.unpack('<B', f.read(1))[0]
-                    texture_id = struct.unpack('<B', f.read(1))[0]
-                    floor_texture_id = struct.unpack('<B', f.read(1))[0]
-                    
-                    self.map_data[y][x] = {
-                        'wall_type': wall_type,
-                        'texture_id': texture_id,
-                        'floor_texture_id': floor_texture_id
-                    }
+        self.map_name = rwm['name']
+        self.map_description = rwm['description']
+        self.map_author = rwm['author']
+        self.map_textures = rwm['textures']
+        self.map_data = rwm['cells']
+        
+        # Update UI
+        self.name_entry.delete(0, tk.END)
+        self.name_entry.insert(0, self.map_name)
+        self.desc_text.delete(1.0, tk.END)
+        self.desc_text.insert(1.0, self.map_description)
+        self.author_entry.delete(0, tk.END)
+        self.author_entry.insert(0, self.map_author)
                     
         self.draw_map()
         self.update_statistics()
         
     def save_rwm_file(self, file_path):
-        """Save an RWM file"""
-        with open(file_path, 'wb') as f:
-            # Write header
-            f.write(b'RWM')  # Magic
-            f.write(struct.pack('<B', 1))  # Version
-            f.write(struct.pack('<H', 16))  # Width
-            f.write(struct.pack('<H', 16))  # Height
-            
-            # Write metadata
-            name_bytes = self.map_name.encode('utf-8')
-            f.write(struct.pack('<B', len(name_bytes)))
-            f.write(name_bytes)
-            
-            desc_bytes = self.map_description.encode('utf-8')
-            f.write(struct.pack('<B', len(desc_bytes)))
-            f.write(desc_bytes)
-            
-            author_bytes = self.map_author.encode('utf-8')
-            f.write(struct.pack('<B', len(author_bytes)))
-            f.write(author_bytes)
-            
-            # Write map data
-            for y in range(16):
-                for x in range(16):
-                    cell = self.map_data[y][x]
-                    f.write(struct.pack('<B', cell['wall_type']))
-                    f.write(struct.pack('<B', cell['texture_id']))
-                    f.write(struct.pack('<B', cell['floor_texture_id']))
+        """Save an RWM file (always version 2)"""
+        rwm = rwm_format.new_map(16, 16)
+        rwm['name'] = self.map_name
+        rwm['description'] = self.map_description
+        rwm['author'] = self.map_author
+        rwm['textures'] = self.map_textures
+        rwm['cells'] = self.map_data
+        rwm_format.write_rwm(file_path, rwm)
                     
     def load_default_map(self):
         """Load a default empty map"""
@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+"""
+RayWhen Map (RWM) file format
+Reads versions 1 and 2 and writes version 2 (see src/map.h for the layout).
+
+Maps are plain dicts:
+    {'name', 'description', 'author', 'width', 'height', 'version',
+     'textures': list of asset paths or None,
+     'cells': rows of {'wall_type', 'texture_id', 'floor_texture_id'}}
+Player and enemy spawns are kept as wall types 5 and 6 in the cells, the
+way the editor paints them; version 2 stores them as entities.
+
+Command line:
+    rwm_format.py info <map.rwm>...
+    rwm_format.py convert <in.rwm> <out.rwm> [--raw]
+"""
+
+import struct
+import sys
+
+MAGIC = b'RWM'
+V2_HEADER_SIZE = 20
+SECTION_SIZE = 32
+CHUNK_ROWS = 64
+ENTITY_SIZE = 16
+
+ENCODING_RAW = 0
+ENCODING_RLE = 1
+
+ENTITY_PLAYER = 1
+ENTITY_ENEMY = 2
+
+WALL_PLAYER_SPAWN = 5
+WALL_ENEMY_SPAWN = 6
+
+# Texture ids 0-15 without a TEXN table (the engine's built-in list, texlib.c)
+BUILTIN_TEXTURES = [
+    "assets/Bricks/REDBRICKS.bmp",
+    "assets/BuildingTextures/BRICKS.bmp",
+    "assets/Industrial/METALTILE.bmp",
+    "assets/Wood/WOODA.bmp",
+    "assets/Tech/HIGHTECH.bmp",
+    "assets/Rocks/GRAYROCKS.bmp",
+    "assets/Bricks/CLAYBRICKS.bmp",
+    "assets/Industrial/CROSSWALL.bmp",
+    "assets/Urban/GRAYWALL.bmp",
+    "assets/Wood/DARKWOOD.bmp",
+    "assets/Tech/HEXAGONS.bmp",
+    "assets/Rocks/DIRT.bmp",
+    "assets/Bricks/BIGBRICKS.bmp",
+    "assets/Industrial/STORAGE.bmp",
+    "assets/Urban/PAVEMENT.bmp",
+    "assets/Wood/WOODTILE.bmp",
+]
+
+
+def new_map(width=16, height=16):
+    """Empty map with default metadata"""
+    return {
+        'name': "Untitled Map",
+        'description': "A RayWhen map",
+        'author': "Unknown",
+        'width': width,
+        'height': height,
+        'version': 2,
+        'textures': None,
+        'cells': [[{'wall_type': 0, 'texture_id': 0, 'floor_texture_id': 0}
+                   for _ in range(width)] for _ in range(height)],
+    }
+
+
+def rle_encode(data, elem_size):
+    """RLE over elements of elem_size bytes (decoder: rleDecode in src/map.c)"""
+    elems = [bytes(data[i:i + elem_size]) for i in range(0, len(data), elem_size)]
+    out = bytearray()
+    literals = []
+
+    def flush_literals():
+        while literals:
+            block = literals[:128]
+            del literals[:128]
+            out.append(len(block) - 1)
+            for e in block:
+                out.extend(e)
+
+    i = 0
+    while i < len(elems):
+        run = 1
+        while i + run < len(elems) and run < 129 and elems[i + run] == elems[i]:
+            run += 1
+        if run >= 2:
+            flush_literals()
+            out.append(run + 126)
+            out += elems[i]
+            i += run
+        else:
+            literals.append(elems[i])
+            i += 1
+    flush_literals()
+    return bytes(out)
+
+
+def rle_decode(data, raw_size, elem_size):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        control = data[i]
+        i += 1
+        if control < 128:
+            n = (control + 1) * elem_size
+            out += data[i:i + n]
+            i += n
+        else:
+            out += data[i:i + elem_size] * (control - 126)
+            i += elem_size
+    if len(out) != raw_size:
+        raise ValueError("Corrupt RLE chunk")
+    return bytes(out)
+
+
+def _read_v1(data):
+    width, height = struct.unpack_from('<HH', data, 4)
+    pos = 8
+    strings = []
+    for default in ("Untitled Map", "A RayWhen map", "Unknown"):
+        n = data[pos]
+        text = data[pos + 1:pos + 1 + n].decode('utf-8', errors='ignore')
+        strings.append(text if n > 0 else default)
+        pos += 1 + n
+    if len(data) - pos < width * height * 3:
+        raise ValueError("Truncated RWM file")
+    cells = []
+    for y in range(height):
+        row = []
+        for x in range(width):
+            wall_type, texture_id, floor_texture_id = data[pos:pos + 3]
+            row.append({'wall_type': wall_type, 'texture_id': texture_id,
+                        'floor_texture_id': floor_texture_id})
+            pos += 3
+        cells.append(row)
+    return {
+        'name': strings[0], 'description': strings[1], 'author': strings[2],
+        'width': width, 'height': height, 'version': 1, 'textures': None,
+        'cells': cells,
+    }
+
+
+def _read_v2(data):
+    width, height, section_count, _flags = struct.unpack_from('<IIII', data, 4)
+    result = new_map(width, height)
+    result['version'] = 2
+    entities = []
+    for i in range(section_count):
+        tag, encoding, first_row, row_count, offset, stored, raw = struct.unpack_from(
+            '<4sIIIQII', data, V2_HEADER_SIZE + i * SECTION_SIZE)
+        payload = data[offset:offset + stored]
+        elem_size = {b'WTEX': 2, b'FTEX': 2, b'ENTS': ENTITY_SIZE}.get(tag, 1)
+        if encoding == ENCODING_RLE:
+            payload = rle_decode(payload, raw, elem_size)
+        elif encoding != ENCODING_RAW:
+            raise ValueError(f"Unknown encoding {encoding} in section {tag!r}")
+
+        if tag == b'META':
+            pos = 0
+            for key in ('name', 'description', 'author'):
+                n = struct.unpack_from('<H', payload, pos)[0]
+                result[key] = payload[pos + 2:pos + 2 + n].decode('utf-8', errors='ignore')
+                pos += 2 + n
+        elif tag == b'TEXN':
+            count = struct.unpack_from('<I', payload, 0)[0]
+            names = payload[4:].split(b'\0')[:count]
+            result['textures'] = [n.decode('utf-8') for n in names]
+        elif tag in (b'WALL', b'WTEX', b'FTEX'):
+            key = {b'WALL': 'wall_type', b'WTEX': 'texture_id', b'FTEX': 'floor_texture_id'}[tag]
+            for r in range(row_count):
+                for x in range(width):
+                    c = r * width + x
+                    value = payload[c] if tag == b'WALL' else struct.unpack_from('<H', payload, c * 2)[0]
+                    result['cells'][first_row + r][x][key] = value
+        elif tag == b'ENTS':
+            for e in range(0, len(payload) - ENTITY_SIZE + 1, ENTITY_SIZE):
+                etype, _reserved, x, y, angle = struct.unpack_from('<HHfff', payload, e)
+                entities.append((etype, x, y, angle))
+
+    # Spawns back into the cells, where the editor paints them
+    for etype, x, y, _angle in entities:
+        cx, cy = int(x), int(y)
+        if 0 <= cx < width and 0 <= cy < height:
+            if etype == ENTITY_PLAYER:
+                result['cells'][cy][cx]['wall_type'] = WALL_PLAYER_SPAWN
+            elif etype == ENTITY_ENEMY:
+                result['cells'][cy][cx]['wall_type'] = WALL_ENEMY_SPAWN
+    return result
+
+
+def read_rwm(file_path):
+    """Load a version 1 or 2 .rwm file"""
+    with open(file_path, 'rb') as f:
+        data = f.read()
+    if len(data) < 8 or data[:3] != MAGIC:
+        raise ValueError("Invalid RWM file - missing magic number")
+    version = data[3]
+    if version == 1:
+        return _read_v1(data)
+    if version == 2:
+        return _read_v2(data)
+    raise ValueError(f"Unsupported RWM version: {version}")
+
+
+def write_rwm(file_path, rwm, compress=True):
+    """Save a map as version 2"""
+    width, height = rwm['width'], rwm['height']
+    cells = rwm['cells']
+    textures = rwm.get('textures') or BUILTIN_TEXTURES
+
+    sections = []  # (tag, first_row, row_count, raw payload, element size)
+
+    meta = bytearray()
+    for key in ('name', 'description', 'author'):
+        text = rwm[key].encode('utf-8')[:65535]
+        meta += struct.pack('<H', len(text)) + text
+    sections.append((b'META', 0, 0, bytes(meta), 1))
+
+    names = bytearray(struct.pack('<I', len(textures)))
+    for name in textures:
+        names += name.encode('utf-8') + b'\0'
+    sections.append((b'TEXN', 0, 0, bytes(names), 1))
+
+    entities = bytearray()
+    for first_row in range(0, height, CHUNK_ROWS):
+        rows = cells[first_row:first_row + CHUNK_ROWS]
+        walls, wall_tex, floor_tex = bytearray(), bytearray(), bytearray()
+        for r, row in enumerate(rows):
+            for x, cell in enumerate(row):
+                wall_type = cell['wall_type']
+                if wall_type in (WALL_PLAYER_SPAWN, WALL_ENEMY_SPAWN):
+                    etype = ENTITY_PLAYER if wall_type == WALL_PLAYER_SPAWN else ENTITY_ENEMY
+                    entities += struct.pack('<HHfff', etype, 0, x + 0.5, first_row + r + 0.5, 0.0)
+                    wall_type = 0
+                walls.append(wall_type)
+                wall_tex += struct.pack('<H', cell['texture_id'])
+                floor_tex += struct.pack('<H', cell['floor_texture_id'])
+        sections.append((b'WALL', first_row, len(rows), bytes(walls), 1))
+        sections.append((b'WTEX', first_row, len(rows), bytes(wall_tex), 2))
+        sections.append((b'FTEX', first_row, len(rows), bytes(floor_tex), 2))
+    sections.append((b'ENTS', 0, 0, bytes(entities), ENTITY_SIZE))
+
+    offset = V2_HEADER_SIZE + SECTION_SIZE * len(sections)
+    table, payloads = bytearray(), bytearray()
+    for tag, first_row, row_count, raw, elem_size in sections:
+        stored, encoding = raw, ENCODING_RAW
+        if compress:
+            packed = rle_encode(raw, elem_size)
+            if len(packed) < len(raw):
+                stored, encoding = packed, ENCODING_RLE
+        table += struct.pack('<4sIIIQII', tag, encoding, first_row, row_count,
+                             offset + len(payloads), len(stored), len(raw))
+        payloads += stored
+
+    with open(file_path, 'wb') as f:
+        f.write(MAGIC + bytes([2]))
+        f.write(struct.pack('<IIII', width, height, len(sections), 0))
+        f.write(table)
+        f.write(payloads)
+
+
+def main(argv):
+    if len(argv) >= 2 and argv[0] == 'info':
+        for path in argv[1:]:
+            rwm = read_rwm(path)
+            print(f"{path}: v{rwm['version']} {rwm['width']}x{rwm['height']} "
+                  f"'{rwm['name']}' by {rwm['author']}")
+        return 0
+    if len(argv) in (3, 4) and argv[0] == 'convert':
+        rwm = read_rwm(argv[1])
+        write_rwm(argv[2], rwm, compress='--raw' not in argv[3:])
+        print(f"{argv[1]} (v{rwm['version']}) -> {argv[2]} (v2)")
+        return 0
+    print("Usage: rwm_format.py info <map.rwm>... | convert <in.rwm> <out.rwm> [--raw]")
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
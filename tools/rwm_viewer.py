@@ -7,9 +7,10 @@ A Python tool to view RWM binary map files in text format using tkinter.
 import tkinter as tk
 from tkinter import ttk, filedialog, messagebox, scrolledtext
 import os
-import struct
 from pathlib import Path
 
+import rwm_format
+
 class RWMViewer:
     def __init__(self, root):
         self.root = root
@@ -122,60 +123,17 @@ class RWMViewer:
             self.status_var.set("Error loading map")
             
     def parse_rwm_file(self, file_path):
-        """Parse RWM binary file format"""
-        with open(file_path, 'rb') as f:
-            # Read header
-            magic = f.read(3)
-            if magic != b'RWM':
-                raise ValueError("Invalid RWM file - missing magic number")
-                
-            version = struct.unpack('<B', f.read(1))[0]
-            if version != 1:
-                raise ValueError(f"Unsupported RWM version: {version}")
-                
-            width = struct.unpack('<H', f.read(2))[0]
-            height = struct.unpack('<H', f.read(2))[0]
-            
-            if width != 16 or height != 16:
-                raise ValueError(f"Unsupported map size: {width}x{height} (expected 16x16)")
-                
-            # Read metadata
-            name_len = struct.unpack('<B', f.read(1))[0]
-            map_name = f.read(name_len).decode('utf-8', errors='ignore') if name_len > 0 else "Untitled"
-            
-            desc_len = struct.unpack('<B', f.read(1))[0]
-            description = f.read(desc_len).decode('utf-8', errors='ignore') if desc_len > 0 else "No description"
-            
-            author_len = struct.unpack('<B', f.read(1))[0]
-            author = f.read(author_len).decode('utf-8', errors='ignore') if author_len > 0 else "Unknown"
-            
-            # Store metadata
-            self.current_metadata = {
-                'name': map_name,
-                'description': description,
-                'author': author,
-                'width': width,
-                'height': height,
-                'version': version
-            }
-            
-            # Read map data
-            map_data = []
-            for y in range(height):
-                row = []
-                for x in range(width):
-                    wall_type = struct.unpack('<B', f.read(1))[0]
-                    texture_id = struct.unpack('<B', f.read(1))[0]
-                    floor_texture_id = struct.unpack('<B', f.read(1))[0]
-                    
-                    row.append({
-                        'wall_type': wall_type,
-                        'texture_id': texture_id,
-                        'floor_texture_id': floor_texture_id
-                    })
-                map_data.append(row)
-                
-            self.current_map_data = map_data
+        """Parse an RWM binary file (version 1 or 2)"""
+        rwm = rwm_format.read_rwm(file_path)
+        self.current_metadata = {
+            'name': rwm['name'],
+            'description': rwm['description'],
+            'author': rwm['author'],
+            'width': rwm['width'],
+            'height': rwm['height'],
+            'version': rwm['version']
+        }
+        self.current_map_data = rwm['cells']
             
     def display_map_data(self):
         """Display the loaded map data in text format"""